@@ -13,15 +13,12 @@ public class Automatron : ModuleRules
         PublicDependencyModuleNames.AddRange(new string[]
 		{
 			"Core",
+			"AutomatronCore",
 			"CoreUObject",
 			"Engine",
 			"FunctionalTesting"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[]
-		{
-		});
-
 		if (Target.bBuildEditor)
 		{
 			PrivateDependencyModuleNames.Add("UnrealEd");
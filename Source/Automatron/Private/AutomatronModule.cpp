@@ -1,10 +1,27 @@
 // Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
 
 #include "AutomatronModule.h"
+#include <Misc/AutomationTest.h>
+
+#include "Misc/MapCache.h"
 
 #define LOCTEXT_NAMESPACE "FAutomatronModule"
 
 
+void FAutomatronModule::StartupModule()
+{
+	// Run services live in AutomatronCore. Only world related state is handled here
+	OnAfterAllTestsHandle = FAutomationTestFramework::Get().OnAfterAllTestsEvent.AddLambda([]()
+	{
+		FSpecMapCache::Get().Reset();
+	});
+}
+
+void FAutomatronModule::ShutdownModule()
+{
+	FAutomationTestFramework::Get().OnAfterAllTestsEvent.Remove(OnAfterAllTestsHandle);
+}
+
 #undef LOCTEXT_NAMESPACE
 
-IMPLEMENT_MODULE(FAutomatronModule, Automatron)
\ No newline at end of file
+IMPLEMENT_MODULE(FAutomatronModule, Automatron)
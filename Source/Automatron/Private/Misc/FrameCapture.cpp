@@ -0,0 +1,142 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/FrameCapture.h"
+#include <Engine/World.h>
+#include <Misc/FileHelper.h>
+
+
+FSpecFrameCapture::FScopedStat::~FScopedStat()
+{
+	Capture.AddStatValue(Stat, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void FSpecFrameCapture::Start(UWorld* InWorld)
+{
+	check(IsInGameThread());
+	Stop();
+
+	World = InWorld;
+	LastTickTime = FPlatformTime::Seconds();
+	FrameTimes.Reset();
+	Stats.Reset();
+	FrameStats.Reset();
+	TickHandle = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FSpecFrameCapture::OnPostActorTick);
+}
+
+void FSpecFrameCapture::Stop()
+{
+	if (TickHandle.IsValid())
+	{
+		FWorldDelegates::OnWorldPostActorTick.Remove(TickHandle);
+		TickHandle.Reset();
+	}
+	World.Reset();
+}
+
+void FSpecFrameCapture::AddStatValue(FName Stat, double Value)
+{
+	check(IsInGameThread());
+	FrameStats.FindOrAdd(Stat) += Value;
+}
+
+void FSpecFrameCapture::SampleStat(FName Stat, TFunction<double()> Getter)
+{
+	Samplers.Add(Stat, MoveTemp(Getter));
+}
+
+const TArray<double>* FSpecFrameCapture::GetValues(FName Stat) const
+{
+	return Stat.IsNone()? &FrameTimes : Stats.Find(Stat);
+}
+
+double FSpecFrameCapture::GetPercentile(double Percentile, FName Stat) const
+{
+	const TArray<double>* Values = GetValues(Stat);
+	if (!Values || Values->Num() == 0)
+	{
+		return 0.0;
+	}
+
+	TArray<double> Sorted = *Values;
+	Sorted.Sort();
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	return Sorted[Index];
+}
+
+double FSpecFrameCapture::GetAverage(FName Stat) const
+{
+	const TArray<double>* Values = GetValues(Stat);
+	if (!Values || Values->Num() == 0)
+	{
+		return 0.0;
+	}
+
+	double Total = 0.0;
+	for (double Value : *Values)
+	{
+		Total += Value;
+	}
+	return Total / Values->Num();
+}
+
+double FSpecFrameCapture::GetMax(FName Stat) const
+{
+	const TArray<double>* Values = GetValues(Stat);
+	return (Values && Values->Num() > 0)? FMath::Max(*Values) : 0.0;
+}
+
+bool FSpecFrameCapture::SaveCsv(const FString& Path) const
+{
+	TArray<FName> StatNames;
+	Stats.GetKeys(StatNames);
+	StatNames.Sort(FNameLexicalLess());
+
+	FString Csv = TEXT("Frame,FrameTime");
+	for (const FName& Stat : StatNames)
+	{
+		Csv += TEXT(",") + Stat.ToString();
+	}
+	Csv += LINE_TERMINATOR;
+
+	for (int32 Frame = 0; Frame < FrameTimes.Num(); ++Frame)
+	{
+		Csv += FString::Printf(TEXT("%i,%.4f"), Frame, FrameTimes[Frame]);
+		for (const FName& Stat : StatNames)
+		{
+			Csv += FString::Printf(TEXT(",%.4f"), Stats[Stat][Frame]);
+		}
+		Csv += LINE_TERMINATOR;
+	}
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+void FSpecFrameCapture::OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != World.Get())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	FrameTimes.Add((Now - LastTickTime) * 1000.0);
+	LastTickTime = Now;
+
+	for (const auto& Sampler : Samplers)
+	{
+		FrameStats.FindOrAdd(Sampler.Key) += Sampler.Value();
+	}
+
+	// Stats are kept aligned with frames. Frames where a stat was not added count as zero
+	const int32 NumFrames = FrameTimes.Num();
+	for (const auto& FrameStat : FrameStats)
+	{
+		TArray<double>& Values = Stats.FindOrAdd(FrameStat.Key);
+		Values.SetNumZeroed(NumFrames - 1);
+		Values.Add(FrameStat.Value);
+	}
+	for (auto& Stat : Stats)
+	{
+		Stat.Value.SetNumZeroed(NumFrames);
+	}
+	FrameStats.Reset();
+}
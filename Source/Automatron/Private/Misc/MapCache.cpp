@@ -0,0 +1,153 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/MapCache.h"
+#include <Engine/World.h>
+#include <HAL/FileManager.h>
+#include <Misc/PackageName.h>
+#include <UObject/Package.h>
+#include <UObject/UObjectGlobals.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+FSpecMapCache& FSpecMapCache::Get()
+{
+	static FSpecMapCache Cache;
+	return Cache;
+}
+
+void FSpecMapCache::Preload(const FString& MapPackage)
+{
+	check(IsInGameThread());
+
+	FEntry& Entry = FindOrAdd(*MapPackage);
+	if (Entry.Package || Entry.RequestId != INDEX_NONE)
+	{
+		return;
+	}
+
+	UE_LOG(LogAutomatron, Verbose, TEXT("Preloading map '%s'"), *MapPackage);
+	const FName PackageName = Entry.PackageName;
+	Entry.RequestId = LoadPackageAsync(MapPackage, FLoadPackageAsyncDelegate::CreateLambda(
+		[this, PackageName](const FName&, UPackage* Package, EAsyncLoadingResult::Type Result)
+		{
+			FEntry* Loaded = Entries.FindByPredicate([PackageName](const FEntry& Other) { return Other.PackageName == PackageName; });
+			if (!Loaded)
+			{
+				return;
+			}
+
+			Loaded->RequestId = INDEX_NONE;
+			if (Result == EAsyncLoadingResult::Succeeded && Package)
+			{
+				Package->AddToRoot();
+				Loaded->Package = Package;
+				Trim(PackageName);
+			}
+			else
+			{
+				UE_LOG(LogAutomatron, Warning, TEXT("Failed to preload map '%s'"), *PackageName.ToString());
+			}
+		}));
+}
+
+UWorld* FSpecMapCache::GetMapWorld(const FString& MapPackage)
+{
+	check(IsInGameThread());
+
+	FEntry& Entry = FindOrAdd(*MapPackage);
+	Entry.LastUse = ++UseCounter;
+
+	if (Entry.RequestId != INDEX_NONE)
+	{
+		FlushAsyncLoading(Entry.RequestId);
+	}
+
+	// Entries may have been trimmed or moved while flushing
+	FEntry* Found = Entries.FindByPredicate([&MapPackage](const FEntry& Other) { return Other.PackageName == *MapPackage; });
+	if (!Found)
+	{
+		return nullptr;
+	}
+
+	if (!Found->Package)
+	{
+		Found->Package = LoadPackage(nullptr, *MapPackage, LOAD_None);
+		if (!Found->Package)
+		{
+			return nullptr;
+		}
+		Found->Package->AddToRoot();
+		Trim(Found->PackageName);
+	}
+	return UWorld::FindWorldInPackage(Found->Package);
+}
+
+void FSpecMapCache::Reset()
+{
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.Package)
+		{
+			Entry.Package->RemoveFromRoot();
+		}
+	}
+	Entries.Empty();
+}
+
+FSpecMapCache::FEntry& FSpecMapCache::FindOrAdd(FName PackageName)
+{
+	if (FEntry* Entry = Entries.FindByPredicate([PackageName](const FEntry& Other) { return Other.PackageName == PackageName; }))
+	{
+		return *Entry;
+	}
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.PackageName = PackageName;
+	Entry.LastUse = ++UseCounter;
+
+	// Size on disk is only an estimate of memory, but it is cheap and stable between runs
+	FString Filename;
+	if (FPackageName::DoesPackageExist(PackageName.ToString(), nullptr, &Filename))
+	{
+		Entry.Size = FMath::Max<int64>(IFileManager::Get().FileSize(*Filename), 0);
+	}
+	return Entry;
+}
+
+void FSpecMapCache::Trim(FName InUse)
+{
+	const int64 Capacity = int64(FAutomatronSettings::Get().MapCacheMB) * 1024 * 1024;
+
+	int64 TotalSize = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		if (Entry.Package)
+		{
+			TotalSize += Entry.Size;
+		}
+	}
+
+	while (TotalSize > Capacity)
+	{
+		FEntry* Oldest = nullptr;
+		for (FEntry& Entry : Entries)
+		{
+			if (Entry.Package && Entry.PackageName != InUse && (!Oldest || Entry.LastUse < Oldest->LastUse))
+			{
+				Oldest = &Entry;
+			}
+		}
+
+		if (!Oldest)
+		{
+			break;
+		}
+
+		UE_LOG(LogAutomatron, Verbose, TEXT("Releasing cached map '%s'"), *Oldest->PackageName.ToString());
+		TotalSize -= Oldest->Size;
+		Oldest->Package->RemoveFromRoot();
+		Oldest->Package = nullptr;
+	}
+}
@@ -0,0 +1,45 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+class UPackage;
+class UWorld;
+
+
+// Keeps map packages loaded across specs so that each map is only loaded from disk once.
+// Least recently used maps are released once their size on disk goes over MapCacheMB.
+class FSpecMapCache
+{
+	struct FEntry
+	{
+		FName PackageName;
+		UPackage* Package = nullptr;
+		int32 RequestId = INDEX_NONE;
+		int64 Size = 0;
+		uint64 LastUse = 0;
+	};
+
+	TArray<FEntry> Entries;
+	uint64 UseCounter = 0;
+
+
+public:
+
+	static FSpecMapCache& Get();
+
+	// Starts loading a map in the background. Does nothing if it is already loaded or loading
+	void Preload(const FString& MapPackage);
+
+	// Returns the world of a map, loading it if needed. The world is a template, it must be duplicated before use
+	UWorld* GetMapWorld(const FString& MapPackage);
+
+	// Releases all cached maps
+	void Reset();
+
+private:
+
+	FEntry& FindOrAdd(FName PackageName);
+	void Trim(FName InUse);
+};
@@ -0,0 +1,397 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/NetSession.h"
+#include <Containers/Ticker.h>
+#include <Engine/ActorChannel.h>
+#include <Engine/Engine.h>
+#include <Engine/GameInstance.h>
+#include <Engine/NetConnection.h>
+#include <Engine/NetDriver.h>
+#include <Engine/PendingNetGame.h>
+#include <Engine/World.h>
+#include <EngineUtils.h>
+#include <GameFramework/PlayerController.h>
+#include <GameFramework/PlayerState.h>
+
+#include "Misc/FrameCapture.h"
+
+
+namespace
+{
+	// Game instances of all running sessions. Only modified on the game thread
+	TArray<const UGameInstance*> SessionInstances;
+
+	// Ticks and browses with GWorld pointing to the world of the instance, as the game engine does
+	struct FScopedGWorld
+	{
+		UWorld* const PreviousWorld;
+
+		FScopedGWorld(UWorld* World) : PreviousWorld(GWorld.GetReference())
+		{
+			if (World)
+			{
+				GWorld = World;
+			}
+		}
+		~FScopedGWorld()
+		{
+			GWorld = PreviousWorld;
+		}
+	};
+
+	int64 GetOutBytes(const UNetConnection* Connection)
+	{
+		return Connection? (int64)Connection->OutTotalBytes : 0;
+	}
+}
+
+
+const FName FSpecNetSession::OutBytesStat{ TEXT("Net.OutBytes") };
+const FName FSpecNetSession::ActorChannelsStat{ TEXT("Net.ActorChannels") };
+
+FName FSpecNetSession::GetClientOutBytesStat(int32 ClientIndex)
+{
+	return *FString::Printf(TEXT("Net.Client%i.OutBytes"), ClientIndex);
+}
+
+FSpecNetSession::FSpecNetSession(FString InName, const FSpecNetConditions& InConditions)
+	: Name(MoveTemp(InName))
+	, Conditions(InConditions)
+{}
+
+FSpecNetSession::~FSpecNetSession()
+{
+	// Nothing to clean up once the engine is gone
+	if (GEngine)
+	{
+		Stop();
+	}
+}
+
+bool FSpecNetSession::Start(const FString& Map, int32 NumClients, FString& OutError)
+{
+	check(IsInGameThread());
+	Stop();
+
+	Server.GameInstance = CreateInstance(FString::Printf(TEXT("%s_Server"), *Name));
+	{
+		FWorldContext& Context = *Server.GameInstance->GetWorldContext();
+		FScopedGWorld ScopedWorld(Context.World());
+
+		FURL URL(nullptr, *FString::Printf(TEXT("%s?listen"), *Map), TRAVEL_Absolute);
+		URL.Port = Conditions.Port;
+		if (GEngine->Browse(Context, URL, OutError) == EBrowseReturnVal::Failure)
+		{
+			Stop();
+			return false;
+		}
+	}
+	ApplyConditions(Server);
+
+	const int32 ServerPort = GetServerPort();
+	if (ServerPort == 0)
+	{
+		OutError = TEXT("The server isn't listening");
+		Stop();
+		return false;
+	}
+
+	for (int32 Index = 0; Index < NumClients; ++Index)
+	{
+		FInstance& Client = Clients.AddDefaulted_GetRef();
+		Client.GameInstance = CreateInstance(FString::Printf(TEXT("%s_Client%i"), *Name, Index));
+
+		// Joining needs a player to log in with
+		FString PlayerError;
+		Client.GameInstance->CreateLocalPlayer(Index, PlayerError, false);
+
+		FWorldContext& Context = *Client.GameInstance->GetWorldContext();
+		FScopedGWorld ScopedWorld(Context.World());
+
+		// Connects while ticking. See TickInstance
+		const FURL URL(nullptr, *FString::Printf(TEXT("127.0.0.1:%i"), ServerPort), TRAVEL_Absolute);
+		if (GEngine->Browse(Context, URL, OutError) == EBrowseReturnVal::Failure)
+		{
+			Stop();
+			return false;
+		}
+		ApplyConditions(Client);
+	}
+
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSpecNetSession::Tick));
+	return true;
+}
+
+void FSpecNetSession::Stop()
+{
+	check(IsInGameThread());
+
+	if (TickHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+
+	// Clients leave before the server closes
+	for (FInstance& Client : Clients)
+	{
+		DestroyInstance(Client);
+	}
+	Clients.Empty();
+	DestroyInstance(Server);
+}
+
+bool FSpecNetSession::IsConnected() const
+{
+	const UWorld* ServerWorld = GetServerWorld();
+	const UNetDriver* ServerDriver = ServerWorld? ServerWorld->GetNetDriver() : nullptr;
+	if (!ServerDriver || ServerDriver->ClientConnections.Num() < Clients.Num())
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Clients.Num(); ++Index)
+	{
+		const UWorld* ClientWorld = GetClientWorld(Index);
+		if (!ClientWorld || ClientWorld->GetNetMode() != NM_Client || !ClientWorld->GetFirstPlayerController())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int32 FSpecNetSession::GetServerPort() const
+{
+	// The driver knows the port it bound, which the URL doesn't when listening on any free port
+	const UWorld* ServerWorld = GetServerWorld();
+	const UNetDriver* ServerDriver = ServerWorld? ServerWorld->GetNetDriver() : nullptr;
+	if (!ServerDriver)
+	{
+		return 0;
+	}
+
+	FString Port;
+	ServerDriver->LowLevelGetNetworkNumber().Split(TEXT(":"), nullptr, &Port, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+	return FCString::Atoi(*Port);
+}
+
+UWorld* FSpecNetSession::GetServerWorld() const
+{
+	return Server.GameInstance? Server.GameInstance->GetWorld() : nullptr;
+}
+
+UWorld* FSpecNetSession::GetClientWorld(int32 ClientIndex) const
+{
+	if (!Clients.IsValidIndex(ClientIndex) || !Clients[ClientIndex].GameInstance)
+	{
+		return nullptr;
+	}
+	return Clients[ClientIndex].GameInstance->GetWorld();
+}
+
+void FSpecNetSession::Step(int32 Frames, float DeltaSeconds)
+{
+	check(IsInGameThread());
+
+	for (int32 Frame = 0; Frame < Frames; ++Frame)
+	{
+		TickInstance(Server, DeltaSeconds);
+		for (FInstance& Client : Clients)
+		{
+			TickInstance(Client, DeltaSeconds);
+		}
+	}
+}
+
+void FSpecNetSession::CaptureBandwidth(FSpecFrameCapture& Capture) const
+{
+	const TWeakObjectPtr<UWorld> ServerWorld = GetServerWorld();
+	auto GetConnections = [ServerWorld]() -> TArray<UNetConnection*>
+	{
+		const UNetDriver* Driver = ServerWorld.IsValid()? ServerWorld->GetNetDriver() : nullptr;
+		return Driver? Driver->ClientConnections : TArray<UNetConnection*>{};
+	};
+
+	// Totals are cumulative. Samplers keep the last value to report what was sent on each frame
+	auto SumOutBytes = [GetConnections]()
+	{
+		int64 Bytes = 0;
+		for (const UNetConnection* Connection : GetConnections())
+		{
+			Bytes += GetOutBytes(Connection);
+		}
+		return Bytes;
+	};
+	Capture.SampleStat(OutBytesStat, [SumOutBytes, LastBytes = SumOutBytes()]() mutable
+	{
+		const int64 Bytes = SumOutBytes();
+		const int64 Sent = Bytes - LastBytes;
+		LastBytes = Bytes;
+		return (double)Sent;
+	});
+
+	// Clients can join in any order, so each connection is found through the player of its client.
+	// Until the player state of a client replicated, its connection is unknown and nothing is reported
+	for (int32 Index = 0; Index < Clients.Num(); ++Index)
+	{
+		const TWeakObjectPtr<UWorld> ClientWorld = GetClientWorld(Index);
+		auto ClientOutBytes = [GetConnections, ClientWorld]() -> int64
+		{
+			const APlayerController* ClientController = ClientWorld.IsValid()? ClientWorld->GetFirstPlayerController() : nullptr;
+			const APlayerState* ClientPlayer = ClientController? ClientController->PlayerState : nullptr;
+			if (!ClientPlayer)
+			{
+				return INDEX_NONE;
+			}
+
+			for (const UNetConnection* Connection : GetConnections())
+			{
+				const APlayerController* ServerController = Connection? Connection->PlayerController : nullptr;
+				if (ServerController && ServerController->PlayerState && ServerController->PlayerState->GetPlayerId() == ClientPlayer->GetPlayerId())
+				{
+					return GetOutBytes(Connection);
+				}
+			}
+			return INDEX_NONE;
+		};
+		Capture.SampleStat(GetClientOutBytesStat(Index), [ClientOutBytes, LastBytes = ClientOutBytes()]() mutable
+		{
+			const int64 Bytes = ClientOutBytes();
+			// Totals only count from the first frame the connection is known
+			const int64 Sent = (Bytes != INDEX_NONE && LastBytes != INDEX_NONE)? Bytes - LastBytes : 0;
+			LastBytes = Bytes;
+			return (double)Sent;
+		});
+	}
+
+	Capture.SampleStat(ActorChannelsStat, [GetConnections]()
+	{
+		int32 Channels = 0;
+		for (const UNetConnection* Connection : GetConnections())
+		{
+			for (const UChannel* Channel : Connection->OpenChannels)
+			{
+				Channels += Cast<UActorChannel>(Channel) != nullptr;
+			}
+		}
+		return (double)Channels;
+	});
+}
+
+bool FSpecNetSession::IsSessionWorld(const UWorld* World)
+{
+	return World && SessionInstances.Contains(World->GetGameInstance());
+}
+
+UGameInstance* FSpecNetSession::CreateInstance(const FString& InstanceName)
+{
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine, *InstanceName);
+	GameInstance->AddToRoot();
+	SessionInstances.Add(GameInstance);
+
+	// Creates a game world context with an empty world, that browsing replaces
+	GameInstance->InitializeStandalone(*InstanceName);
+	return GameInstance;
+}
+
+void FSpecNetSession::DestroyInstance(FInstance& Instance)
+{
+	if (!Instance.GameInstance)
+	{
+		return;
+	}
+
+	FWorldContext& Context = *Instance.GameInstance->GetWorldContext();
+	GEngine->CancelPending(Context);
+
+	if (UWorld* World = Context.World())
+	{
+		World->BeginTearingDown();
+		GEngine->ShutdownWorldNetDriver(World);
+
+		for (FActorIterator ActorIt(World); ActorIt; ++ActorIt)
+		{
+			ActorIt->RouteEndPlay(EEndPlayReason::Quit);
+		}
+
+		Instance.GameInstance->Shutdown();
+		World->DestroyWorld(false);
+		GEngine->DestroyWorldContext(World);
+	}
+	else
+	{
+		Instance.GameInstance->Shutdown();
+	}
+
+	SessionInstances.RemoveSingleSwap(Instance.GameInstance);
+	Instance.GameInstance->RemoveFromRoot();
+	Instance = {};
+}
+
+bool FSpecNetSession::Tick(float DeltaTime)
+{
+	// The game engine ticks every Game context already, but the editor only ticks its own world and PIE
+	if (GIsEditor)
+	{
+		Step(1, Conditions.FixedDeltaSeconds > 0.f? Conditions.FixedDeltaSeconds : DeltaTime);
+	}
+	else
+	{
+		// Clients switch drivers when they join
+		ApplyConditions(Server);
+		for (FInstance& Client : Clients)
+		{
+			ApplyConditions(Client);
+		}
+	}
+	return true;
+}
+
+void FSpecNetSession::TickInstance(FInstance& Instance, float DeltaSeconds)
+{
+	if (!Instance.GameInstance)
+	{
+		return;
+	}
+
+	FWorldContext& Context = *Instance.GameInstance->GetWorldContext();
+	FScopedGWorld ScopedWorld(Context.World());
+
+	// Completes pending connections, loading the server map on clients
+	GEngine->TickWorldTravel(Context, DeltaSeconds);
+
+	if (UWorld* World = Context.World())
+	{
+		GWorld = World;
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+	}
+
+	ApplyConditions(Instance);
+}
+
+void FSpecNetSession::ApplyConditions(FInstance& Instance)
+{
+#if DO_ENABLE_NET_TEST
+	const FWorldContext& Context = *Instance.GameInstance->GetWorldContext();
+
+	// Clients use the driver of the pending game until they join
+	UNetDriver* Driver = Context.PendingNetGame? Context.PendingNetGame->NetDriver : nullptr;
+	if (!Driver && Context.World())
+	{
+		Driver = Context.World()->GetNetDriver();
+	}
+
+	if (!Driver || Instance.ConditionedDriver == Driver)
+	{
+		return;
+	}
+
+	FPacketSimulationSettings Settings;
+	Settings.PktLag = Conditions.LagMs;
+	Settings.PktLagVariance = Conditions.LagVarianceMs;
+	Settings.PktLoss = Conditions.LossPercent;
+	Driver->SetPacketSimulationSettings(Settings);
+	Instance.ConditionedDriver = Driver;
+#endif
+}
@@ -0,0 +1,327 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/Replay.h"
+#include <Engine/World.h>
+#include <EngineUtils.h>
+#include <Hash/CityHash.h>
+#include <Misc/App.h>
+#include <Misc/CoreDelegates.h>
+#include <HAL/FileManager.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <Serialization/MemoryReader.h>
+#include <Serialization/MemoryWriter.h>
+
+
+namespace
+{
+	// "ATRP"
+	constexpr uint32 ReplayMagic = 0x50525441;
+	// 2: Hash of the initial state
+	constexpr uint32 ReplayVersion = 2;
+
+	// Transforms are quantized so that float noise doesn't change the hash
+	constexpr float LocationTolerance = 0.01f;
+	constexpr float RotationTolerance = 0.01f;
+	constexpr float ScaleTolerance = 0.001f;
+
+	int32 Quantize(float Value, float Tolerance)
+	{
+		return FMath::RoundToInt(Value / Tolerance);
+	}
+
+	// Every element takes at least a byte, so a count over the remaining size means a corrupt file
+	bool CanRead(FArchive& Ar, uint32 Count)
+	{
+		if (Ar.IsLoading() && (Ar.IsError() || Count > (uint64)(Ar.TotalSize() - Ar.Tell())))
+		{
+			Ar.SetError();
+			return false;
+		}
+		return true;
+	}
+}
+
+
+void FSpecReplay::AddFrame(float InDeltaSeconds, const TArray<TPair<FName, float>>& FrameInputs)
+{
+	DeltaSeconds.Add(InDeltaSeconds);
+	FirstInputs.Add(Inputs.Num());
+	for (const TPair<FName, float>& Input : FrameInputs)
+	{
+		Inputs.Add({ FindOrAddChannel(Input.Key), Input.Value });
+	}
+}
+
+void FSpecReplay::ApplyInputs(int32 Frame, const FSpecReplayInputHandler& Handler) const
+{
+	const int32 End = FirstInputs.IsValidIndex(Frame + 1)? FirstInputs[Frame + 1] : Inputs.Num();
+	for (int32 Index = FirstInputs[Frame]; Index < End; ++Index)
+	{
+		Handler(Channels[Inputs[Index].Channel], Inputs[Index].Value);
+	}
+}
+
+bool FSpecReplay::Save(const FString& Path) const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer{ Data };
+	// Saving doesn't modify the replay
+	const_cast<FSpecReplay*>(this)->Serialize(Writer);
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	return FFileHelper::SaveArrayToFile(Data, *Path);
+}
+
+bool FSpecReplay::Load(const FString& Path)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Path))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader{ Data };
+	Serialize(Reader);
+	return !Reader.IsError();
+}
+
+uint64 FSpecReplay::HashWorldState(UWorld* World)
+{
+	if (!World)
+	{
+		return 0;
+	}
+
+	TArray<uint64> ActorHashes;
+	for (FActorIterator ActorIt(World); ActorIt; ++ActorIt)
+	{
+		const FTransform Transform = ActorIt->GetActorTransform();
+		const FVector Location = Transform.GetLocation();
+		const FRotator Rotation = Transform.Rotator();
+		const FVector Scale = Transform.GetScale3D();
+
+		const int32 Quantized[] = {
+			Quantize(Location.X, LocationTolerance), Quantize(Location.Y, LocationTolerance), Quantize(Location.Z, LocationTolerance),
+			Quantize(Rotation.Pitch, RotationTolerance), Quantize(Rotation.Yaw, RotationTolerance), Quantize(Rotation.Roll, RotationTolerance),
+			Quantize(Scale.X, ScaleTolerance), Quantize(Scale.Y, ScaleTolerance), Quantize(Scale.Z, ScaleTolerance)
+		};
+
+		// Names of spawned actors can change between runs. Their class can't
+		const FString ClassPath = ActorIt->GetClass()->GetPathName();
+		const uint64 ClassHash = CityHash64((const char*)*ClassPath, ClassPath.Len() * sizeof(TCHAR));
+		ActorHashes.Add(CityHash64WithSeed((const char*)Quantized, sizeof(Quantized), ClassHash));
+	}
+
+	// Independent of the order actors are iterated in
+	ActorHashes.Sort();
+	return CityHash64((const char*)ActorHashes.GetData(), ActorHashes.Num() * sizeof(uint64));
+}
+
+int32 FSpecReplay::FindOrAddChannel(FName Channel)
+{
+	const int32 Index = Channels.Find(Channel);
+	return Index != INDEX_NONE? Index : Channels.Add(Channel);
+}
+
+void FSpecReplay::Serialize(FArchive& Ar)
+{
+	uint32 Magic = ReplayMagic;
+	uint32 Version = ReplayVersion;
+	Ar << Magic << Version;
+	if (Magic != ReplayMagic || Version != ReplayVersion)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << InitialStateHash;
+
+	uint32 NumChannels = Channels.Num();
+	Ar.SerializeIntPacked(NumChannels);
+	if (!CanRead(Ar, NumChannels))
+	{
+		return;
+	}
+	Channels.SetNum(NumChannels);
+	for (FName& Channel : Channels)
+	{
+		FString ChannelName = Channel.ToString();
+		Ar << ChannelName;
+		Channel = *ChannelName;
+	}
+
+	uint32 NumFrames = DeltaSeconds.Num();
+	Ar.SerializeIntPacked(NumFrames);
+	if (!CanRead(Ar, NumFrames))
+	{
+		return;
+	}
+	DeltaSeconds.SetNum(NumFrames);
+	FirstInputs.SetNum(NumFrames);
+	if (Ar.IsLoading())
+	{
+		Inputs.Reset();
+	}
+
+	for (int32 Frame = 0; Frame < (int32)NumFrames; ++Frame)
+	{
+		Ar << DeltaSeconds[Frame];
+
+		// Most frames have no inputs, so only their count is stored
+		uint32 NumInputs = 0;
+		if (Ar.IsSaving())
+		{
+			const int32 End = FirstInputs.IsValidIndex(Frame + 1)? FirstInputs[Frame + 1] : Inputs.Num();
+			NumInputs = End - FirstInputs[Frame];
+		}
+		Ar.SerializeIntPacked(NumInputs);
+		if (!CanRead(Ar, NumInputs))
+		{
+			return;
+		}
+
+		if (Ar.IsLoading())
+		{
+			FirstInputs[Frame] = Inputs.Num();
+			Inputs.AddUninitialized(NumInputs);
+		}
+		for (int32 Index = FirstInputs[Frame]; Index < FirstInputs[Frame] + (int32)NumInputs; ++Index)
+		{
+			uint32 Channel = Inputs[Index].Channel;
+			Ar.SerializeIntPacked(Channel);
+			Inputs[Index].Channel = Channel;
+			Ar << Inputs[Index].Value;
+
+			if (Ar.IsLoading() && !Channels.IsValidIndex(Inputs[Index].Channel))
+			{
+				Ar.SetError();
+				return;
+			}
+		}
+	}
+
+	Ar << FinalStateHash;
+}
+
+
+void FSpecReplayRecorder::Start(UWorld* InWorld)
+{
+	check(IsInGameThread());
+	Stop();
+
+	World = InWorld;
+	Replay = {};
+	Replay.SetInitialStateHash(FSpecReplay::HashWorldState(InWorld));
+	PendingInputs.Reset();
+	TickHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FSpecReplayRecorder::OnWorldTickStart);
+}
+
+FSpecReplay FSpecReplayRecorder::Stop()
+{
+	if (TickHandle.IsValid())
+	{
+		FWorldDelegates::OnWorldTickStart.Remove(TickHandle);
+		TickHandle.Reset();
+		Replay.SetFinalStateHash(FSpecReplay::HashWorldState(World.Get()));
+	}
+	World.Reset();
+	PendingInputs.Reset();
+	return MoveTemp(Replay);
+}
+
+void FSpecReplayRecorder::RecordInput(FName Channel, float Value)
+{
+	check(IsInGameThread());
+	if (IsRecording())
+	{
+		PendingInputs.Emplace(Channel, Value);
+	}
+}
+
+void FSpecReplayRecorder::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == World.Get())
+	{
+		Replay.AddFrame(DeltaSeconds, PendingInputs);
+		PendingInputs.Reset();
+	}
+}
+
+
+void FSpecReplayPlayer::Start(UWorld* InWorld, FSpecReplay&& InReplay, FSpecReplayInputHandler InInputHandler, TFunction<void()> InOnFinished)
+{
+	check(IsInGameThread());
+	Stop();
+
+	World = InWorld;
+	Replay = MoveTemp(InReplay);
+	InputHandler = MoveTemp(InInputHandler);
+	OnFinished = MoveTemp(InOnFinished);
+	Frame = 0;
+	bStarted = false;
+
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	if (Replay.GetNumFrames() > 0)
+	{
+		FApp::SetUseFixedTimeStep(true);
+		FApp::SetFixedDeltaTime(Replay.GetDeltaSeconds(0));
+	}
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FSpecReplayPlayer::OnBeginFrame);
+	TickHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FSpecReplayPlayer::OnWorldTickStart);
+}
+
+void FSpecReplayPlayer::Stop()
+{
+	if (!IsPlaying())
+	{
+		return;
+	}
+
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	BeginFrameHandle.Reset();
+	FWorldDelegates::OnWorldTickStart.Remove(TickHandle);
+	TickHandle.Reset();
+
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	World.Reset();
+	InputHandler = {};
+	OnFinished = {};
+}
+
+void FSpecReplayPlayer::OnBeginFrame()
+{
+	// The world may have ticked in the frame playback was started on. Its delta wasn't recorded
+	bStarted = true;
+
+	if (Frame >= Replay.GetNumFrames() || !World.IsValid())
+	{
+		TFunction<void()> Finished = MoveTemp(OnFinished);
+		Stop();
+		if (Finished)
+		{
+			Finished();
+		}
+	}
+}
+
+void FSpecReplayPlayer::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (!bStarted || InWorld != World.Get() || Frame >= Replay.GetNumFrames())
+	{
+		return;
+	}
+
+	Replay.ApplyInputs(Frame, InputHandler);
+	++Frame;
+
+	// Time of the next engine frame
+	if (Frame < Replay.GetNumFrames())
+	{
+		FApp::SetFixedDeltaTime(Replay.GetDeltaSeconds(Frame));
+	}
+}
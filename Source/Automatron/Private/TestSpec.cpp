@@ -1,7 +1,14 @@
 // Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
 
 #include "TestSpec.h"
+#include <Containers/Ticker.h>
+#include <Engine/GameInstance.h>
 #include <EngineUtils.h>
+#include <UObject/Package.h>
+#include <UObject/UnrealType.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/MapCache.h"
 
 #if WITH_EDITOR
 #include <Tests/AutomationEditorPromotionCommon.h>
@@ -9,6 +16,35 @@
 #endif
 
 
+namespace
+{
+	// Worlds owned by specs with bUseIsolatedWorld. Only modified on the game thread
+	TArray<UWorld*> IsolatedWorlds;
+
+	TArray<FTestSpec*>& GetAllSpecs()
+	{
+		static TArray<FTestSpec*> AllSpecs;
+		return AllSpecs;
+	}
+}
+
+
+FTestSpec::FTestSpec()
+{
+	GetAllSpecs().Add(this);
+}
+
+FTestSpec::~FTestSpec()
+{
+	GetAllSpecs().RemoveSingleSwap(this);
+}
+
+bool FTestSpec::RunTest(const FString& InParameters)
+{
+	PreloadNextMap();
+	return FTestSpecBase::RunTest(InParameters);
+}
+
 void FTestSpec::PreDefine()
 {
 	FTestSpecBase::PreDefine();
@@ -32,6 +68,9 @@ void FTestSpec::PostDefine()
 {
 	AfterEach([this]()
 	{
+		// Replays abandoned by a timeout must not keep driving the time step of the engine
+		ReplayPlayer.Stop();
+
 		// If this spec initialized a PIE world, tear it down
 		if (!bReuseWorldForAllTests || IsLastTest())
 		{
@@ -42,10 +81,44 @@ void FTestSpec::PostDefine()
 	FTestSpecBase::PostDefine();
 }
 
+void FTestSpec::OnFailFast()
+{
+	// Skipped tests won't reach the AfterEach releasing the world
+	ReleaseTestWorld();
+}
+
 void FTestSpec::PrepareTestWorld(FSpecBaseOnWorldReady OnWorldReady)
 {
 	checkf(!IsInGameThread(), TEXT("PrepareTestWorld can only be done asynchronously. (LatentBeforeEach with ThreadPool or TaskGraph)"));
 
+	if (UsesIsolatedWorld())
+	{
+		UWorld* CreatedWorld = nullptr;
+		FEvent* WorldCreated = FPlatformProcess::GetSynchEventFromPool();
+		AsyncTask(ENamedThreads::GameThread, [&]()
+		{
+			if (NetClients > 0)
+			{
+				CreatedWorld = NetSession? NetSession->GetServerWorld() : StartNetSession();
+			}
+			else
+			{
+				CreatedWorld = IsolatedWorld? IsolatedWorld : CreateIsolatedWorld();
+			}
+			WorldCreated->Trigger();
+		});
+		WorldCreated->Wait();
+		FPlatformProcess::ReturnSynchEventToPool(WorldCreated);
+
+		if (CreatedWorld && NetClients > 0 && !WaitForNetClients())
+		{
+			AddError(FString::Printf(TEXT("%i net clients didn't connect in %.1fs"), NetClients, DefaultTimeout.GetTotalSeconds()), 0);
+		}
+
+		OnWorldReady.ExecuteIfBound(CreatedWorld);
+		return;
+	}
+
 	UWorld* SelectedWorld = FindGameWorld();
 
 #if WITH_EDITOR
@@ -102,6 +175,18 @@ void FTestSpec::ReleaseTestWorld()
 		return;
 	}
 
+	if (NetSession)
+	{
+		StopNetSession();
+		return;
+	}
+
+	if (IsolatedWorld)
+	{
+		DestroyIsolatedWorld();
+		return;
+	}
+
 #if WITH_EDITOR
 	if (bInitializedPIE)
 	{
@@ -143,12 +228,253 @@ void FTestSpec::ReleaseTestWorld()
 	}
 }
 
+bool FTestSpec::TestFrameBudget(const FSpecFrameCapture& Capture, double Percentile, double BudgetMs, FName Stat)
+{
+	const FString StatName = Stat.IsNone()? TEXT("Frame time") : Stat.ToString();
+	if (Capture.GetNumFrames() == 0)
+	{
+		AddError(FString::Printf(TEXT("%s: no frames were captured."), *StatName), 1);
+		return false;
+	}
+
+	const double Value = Capture.GetPercentile(Percentile, Stat);
+	if (Value > BudgetMs)
+	{
+		AddError(FString::Printf(TEXT("%s: p%.1f is %.3fms, over the budget of %.3fms (%i frames, max %.3fms)."),
+			*StatName, Percentile * 100.0, Value, BudgetMs, Capture.GetNumFrames(), Capture.GetMax(Stat)), 1);
+		return false;
+	}
+	return true;
+}
+
+bool FTestSpec::TestAverageBudget(const FSpecFrameCapture& Capture, double BudgetMs, FName Stat)
+{
+	const FString StatName = Stat.IsNone()? TEXT("Frame time") : Stat.ToString();
+	if (Capture.GetNumFrames() == 0)
+	{
+		AddError(FString::Printf(TEXT("%s: no frames were captured."), *StatName), 1);
+		return false;
+	}
+
+	const double Value = Capture.GetAverage(Stat);
+	if (Value > BudgetMs)
+	{
+		AddError(FString::Printf(TEXT("%s: average is %.3fms, over the budget of %.3fms (%i frames)."),
+			*StatName, Value, BudgetMs, Capture.GetNumFrames()), 1);
+		return false;
+	}
+	return true;
+}
+
+void FTestSpec::ExportFrameCapture(const FSpecFrameCapture& Capture, const FString& Name)
+{
+	const FString Path = FAutomatronSettings::Get().FrameCaptureDir / GetClassName() / FPaths::MakeValidFileName(Name) + TEXT(".csv");
+	if (Capture.SaveCsv(Path))
+	{
+		AddInfo(FString::Printf(TEXT("Frame capture saved to '%s'"), *Path));
+	}
+	else
+	{
+		AddWarning(FString::Printf(TEXT("Failed to save frame capture to '%s'"), *Path), 1);
+	}
+}
+
+void FTestSpec::CapturedLatentIt(const FString& InDescription, TFunction<void(FSpecFrameCapture&, const FDoneDelegate&)> DoWork, TFunction<void(const FSpecFrameCapture&)> CheckBudgets)
+{
+	CapturedLatentIt(InDescription, DefaultTimeout, MoveTemp(DoWork), MoveTemp(CheckBudgets));
+}
+
+void FTestSpec::CapturedLatentIt(const FString& InDescription, const FTimespan& Timeout, TFunction<void(FSpecFrameCapture&, const FDoneDelegate&)> DoWork, TFunction<void(const FSpecFrameCapture&)> CheckBudgets)
+{
+	// A scope of its own, so that the capture covers the body only and AfterEach stops it even on timeouts
+	const TSharedRef<FSpecFrameCapture> Capture = MakeShared<FSpecFrameCapture>();
+	Describe(InDescription, [this, InDescription, Timeout, Capture, DoWork = MoveTemp(DoWork), CheckBudgets = MoveTemp(CheckBudgets)]()
+	{
+		BeforeEach([this, Capture]()
+		{
+			Capture->Start(GetWorld());
+		});
+
+		LatentIt(FString(), Timeout, [Capture, DoWork](const FDoneDelegate& Done)
+		{
+			DoWork(*Capture, Done);
+		});
+
+		AfterEach([this, InDescription, Capture, CheckBudgets]()
+		{
+			Capture->Stop();
+			ExportFrameCapture(*Capture, InDescription);
+
+			// Budgets of a test that failed already are meaningless
+			if (CheckBudgets && !HasAnyErrors())
+			{
+				CheckBudgets(*Capture);
+			}
+		});
+	});
+}
+
+UWorld* FTestSpec::GetClientWorld(int32 ClientIndex) const
+{
+	return NetSession? NetSession->GetClientWorld(ClientIndex) : nullptr;
+}
+
+int32 FTestSpec::GetNumClientWorlds() const
+{
+	return NetSession? NetSession->GetNumClients() : 0;
+}
+
+void FTestSpec::StepNetWorlds(int32 Frames, float DeltaSeconds)
+{
+	if (!NetSession)
+	{
+		AddError(TEXT("StepNetWorlds needs NetClients above zero"), 1);
+		return;
+	}
+	NetSession->Step(Frames, DeltaSeconds);
+}
+
+void FTestSpec::CaptureNetBandwidth(FSpecFrameCapture& Capture) const
+{
+	if (NetSession)
+	{
+		NetSession->CaptureBandwidth(Capture);
+	}
+}
+
+bool FTestSpec::TestNetBandwidth(const FSpecFrameCapture& Capture, double Percentile, double BudgetBytes, FName Stat)
+{
+	const TArray<double>* Values = Capture.GetValues(Stat);
+	if (!Values || Values->Num() == 0)
+	{
+		AddError(FString::Printf(TEXT("%s: no frames were captured."), *Stat.ToString()), 1);
+		return false;
+	}
+
+	const double Value = Capture.GetPercentile(Percentile, Stat);
+	if (Value > BudgetBytes)
+	{
+		AddError(FString::Printf(TEXT("%s: p%.1f is %.0f bytes per frame, over the budget of %.0f bytes (%i frames, max %.0f bytes)."),
+			*Stat.ToString(), Percentile * 100.0, Value, BudgetBytes, Values->Num(), Capture.GetMax(Stat)), 1);
+		return false;
+	}
+	return true;
+}
+
+void FTestSpec::StartRecording(FSpecReplayInputHandler InputHandler)
+{
+	check(IsInGameThread());
+	RecordingInputHandler = MoveTemp(InputHandler);
+	ReplayRecorder.Start(GetWorld());
+}
+
+bool FTestSpec::StopRecording(const FString& Name)
+{
+	check(IsInGameThread());
+	RecordingInputHandler = {};
+
+	if (!ReplayRecorder.IsRecording())
+	{
+		AddError(TEXT("StopRecording called without StartRecording"), 1);
+		return false;
+	}
+
+	const FSpecReplay Replay = ReplayRecorder.Stop();
+	const FString Path = GetReplayPath(Name);
+	if (!Replay.Save(Path))
+	{
+		AddError(FString::Printf(TEXT("Failed to save replay '%s'"), *Path), 1);
+		return false;
+	}
+	AddInfo(FString::Printf(TEXT("Recorded %i frames to '%s'"), Replay.GetNumFrames(), *Path));
+	return true;
+}
+
+void FTestSpec::ApplyInput(FName Channel, float Value)
+{
+	ReplayRecorder.RecordInput(Channel, Value);
+	if (RecordingInputHandler)
+	{
+		RecordingInputHandler(Channel, Value);
+	}
+}
+
+void FTestSpec::PlayReplay(const FString& Name, FSpecReplayInputHandler InputHandler, const FDoneDelegate& Done)
+{
+	check(IsInGameThread());
+
+	UWorld* WorldPtr = GetWorld();
+	if (!WorldPtr)
+	{
+		AddError(TEXT("PlayReplay needs a world"), 1);
+		Done.ExecuteIfBound();
+		return;
+	}
+
+	const FString Path = GetReplayPath(Name);
+	FSpecReplay Replay;
+	if (!Replay.Load(Path))
+	{
+		AddError(FString::Printf(TEXT("Failed to load replay '%s'. Record it again with StartRecording"), *Path), 1);
+		Done.ExecuteIfBound();
+		return;
+	}
+
+	// Inputs only reproduce the recording from the same starting point
+	const uint64 InitialStateHash = FSpecReplay::HashWorldState(WorldPtr);
+	if (InitialStateHash != Replay.GetInitialStateHash())
+	{
+		AddError(FString::Printf(TEXT("Replay '%s' starts from a different state (hash %016llx, recorded %016llx)"),
+			*Name, InitialStateHash, Replay.GetInitialStateHash()), 1);
+		Done.ExecuteIfBound();
+		return;
+	}
+
+	ReplayPlayer.Start(WorldPtr, MoveTemp(Replay), MoveTemp(InputHandler), [this, Name, Done]()
+	{
+		const FSpecReplay& Played = ReplayPlayer.GetReplay();
+		const uint64 StateHash = FSpecReplay::HashWorldState(GetWorld());
+		if (StateHash != Played.GetFinalStateHash())
+		{
+			AddError(FString::Printf(TEXT("Replay '%s' ended in a different state after %i frames (hash %016llx, recorded %016llx)"),
+				*Name, Played.GetNumFrames(), StateHash, Played.GetFinalStateHash()), 0);
+		}
+		Done.ExecuteIfBound();
+	});
+}
+
+bool FTestSpec::TestMatchesSnapshot(const FString& Name, const UScriptStruct* Struct, const void* Value)
+{
+	check(Struct && Value);
+
+	// One property per line
+	FString Text;
+	for (TFieldIterator<FProperty> It(Struct); It; ++It)
+	{
+		for (int32 Index = 0; Index < It->ArrayDim; ++Index)
+		{
+			FString ValueText;
+			It->ExportTextItem(ValueText, It->ContainerPtrToValuePtr<void>(Value, Index), nullptr, nullptr, PPF_None);
+
+			Text += It->GetName();
+			if (It->ArrayDim > 1)
+			{
+				Text += FString::Printf(TEXT("[%i]"), Index);
+			}
+			Text += TEXT("=") + ValueText + TEXT("\n");
+		}
+	}
+
+	const FTCHARToUTF8 Utf8Text(*Text);
+	return CompareSnapshot(Name, TArrayView<const uint8>((const uint8*)Utf8Text.Get(), Utf8Text.Length()), true);
+}
+
 UWorld* FTestSpec::FindGameWorld()
 {
 	const TIndirectArray<FWorldContext>& WorldContexts = GEngine->GetWorldContexts();
 	for (const FWorldContext& Context : WorldContexts)
 	{
-		if (Context.World() != nullptr)
+		if (Context.World() != nullptr && !IsolatedWorlds.Contains(Context.World()) && !FSpecNetSession::IsSessionWorld(Context.World()))
 		{
 			if (Context.WorldType == EWorldType::PIE /*&& Context.PIEInstance == 0*/)
 			{
@@ -163,3 +489,172 @@ UWorld* FTestSpec::FindGameWorld()
 	}
 	return nullptr;
 }
+
+UWorld* FTestSpec::CreateIsolatedWorld()
+{
+	check(IsInGameThread());
+
+	const FName WorldName = MakeUniqueObjectName(GetTransientPackage(), UWorld::StaticClass(), *FString::Printf(TEXT("Automatron_%s"), *GetClassName()));
+
+	UWorld* MapWorld = nullptr;
+	if (!TestMap.IsEmpty())
+	{
+		MapWorld = FSpecMapCache::Get().GetMapWorld(TestMap);
+		if (!MapWorld)
+		{
+			AddError(FString::Printf(TEXT("Failed to load test map '%s'"), *TestMap), 0);
+			return nullptr;
+		}
+	}
+
+	// Worlds only begin play through a game mode, which needs a game instance. Creates a context with an empty world
+	IsolatedGameInstance = NewObject<UGameInstance>(GEngine, *WorldName.ToString());
+	IsolatedGameInstance->AddToRoot();
+	IsolatedGameInstance->InitializeStandalone(WorldName);
+
+	FWorldContext& Context = *IsolatedGameInstance->GetWorldContext();
+	IsolatedWorld = Context.World();
+	if (MapWorld)
+	{
+		// The cached map stays untouched. Each spec plays on its own copy
+		UPackage* WorldPackage = CreatePackage(nullptr, *FString::Printf(TEXT("/Temp/Automatron/%s"), *WorldName.ToString()));
+		UWorld* MapCopy = CastChecked<UWorld>(StaticDuplicateObject(MapWorld, WorldPackage, MapWorld->GetFName(), RF_AllFlags, nullptr, EDuplicateMode::PIE));
+		MapCopy->WorldType = EWorldType::Game;
+		MapCopy->SetGameInstance(IsolatedGameInstance);
+		MapCopy->InitWorld();
+
+		IsolatedWorld->DestroyWorld(false, MapCopy);
+		Context.SetCurrentWorld(MapCopy);
+		IsolatedWorld = MapCopy;
+	}
+	IsolatedWorld->AddToRoot();
+	IsolatedWorlds.Add(IsolatedWorld);
+
+	const FURL URL;
+	IsolatedWorld->SetGameMode(URL);
+	IsolatedWorld->InitializeActorsForPlay(URL);
+	IsolatedWorld->BeginPlay();
+
+	// The game engine ticks every Game context already, but the editor only ticks its own world and PIE
+	if (GIsEditor)
+	{
+		IsolatedWorldTickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FTestSpec::TickIsolatedWorld));
+	}
+	return IsolatedWorld;
+}
+
+void FTestSpec::DestroyIsolatedWorld()
+{
+	check(IsInGameThread());
+
+	if (IsolatedWorldTickHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(IsolatedWorldTickHandle);
+		IsolatedWorldTickHandle.Reset();
+	}
+
+	IsolatedWorld->BeginTearingDown();
+	for (FActorIterator ActorIt(IsolatedWorld); ActorIt; ++ActorIt)
+	{
+		ActorIt->RouteEndPlay(EEndPlayReason::Quit);
+	}
+
+	IsolatedGameInstance->Shutdown();
+	IsolatedWorld->DestroyWorld(false);
+	GEngine->DestroyWorldContext(IsolatedWorld);
+	IsolatedWorld->RemoveFromRoot();
+	IsolatedWorlds.Remove(IsolatedWorld);
+	IsolatedGameInstance->RemoveFromRoot();
+
+	IsolatedWorld = nullptr;
+	IsolatedGameInstance = nullptr;
+	World.Reset();
+}
+
+UWorld* FTestSpec::StartNetSession()
+{
+	check(IsInGameThread());
+
+	const FString Map = TestMap.IsEmpty()? TEXT("/Engine/Maps/Entry") : TestMap;
+	NetSession = MakeUnique<FSpecNetSession>(FString::Printf(TEXT("Automatron_%s"), *GetClassName()), NetConditions);
+
+	FString Error;
+	if (!NetSession->Start(Map, NetClients, Error))
+	{
+		AddError(FString::Printf(TEXT("Failed to start a listen server on '%s': %s"), *Map, *Error), 0);
+		NetSession.Reset();
+		return nullptr;
+	}
+	return NetSession->GetServerWorld();
+}
+
+void FTestSpec::StopNetSession()
+{
+	check(IsInGameThread());
+
+	NetSession.Reset();
+	World.Reset();
+}
+
+bool FTestSpec::WaitForNetClients() const
+{
+	check(!IsInGameThread());
+
+	const double Timeout = FPlatformTime::Seconds() + DefaultTimeout.GetTotalSeconds();
+	while (FPlatformTime::Seconds() < Timeout)
+	{
+		bool bConnected = false;
+		FEvent* Checked = FPlatformProcess::GetSynchEventFromPool();
+		AsyncTask(ENamedThreads::GameThread, [&]()
+		{
+			bConnected = NetSession && NetSession->IsConnected();
+			Checked->Trigger();
+		});
+		Checked->Wait();
+		FPlatformProcess::ReturnSynchEventToPool(Checked);
+
+		if (bConnected)
+		{
+			return true;
+		}
+		FPlatformProcess::Sleep(0.005f);
+	}
+	return false;
+}
+
+FString FTestSpec::GetReplayPath(const FString& Name) const
+{
+	return FPaths::GetPath(GetTestSourceFileName()) / TEXT("Replays") / FPaths::MakeValidFileName(TestName) / FPaths::MakeValidFileName(Name) + TEXT(".replay");
+}
+
+void FTestSpec::PreloadNextMap() const
+{
+	// Specs run sorted by name. The next one with a different map is loaded while this one runs
+	const FTestSpec* Next = nullptr;
+	for (const FTestSpec* Spec : GetAllSpecs())
+	{
+		if (!Spec->TestMap.IsEmpty() && Spec->TestMap != TestMap && Spec->TestName > TestName &&
+			(!Next || Spec->TestName < Next->TestName))
+		{
+			Next = Spec;
+		}
+	}
+
+	if (!TestMap.IsEmpty())
+	{
+		FSpecMapCache::Get().Preload(TestMap);
+	}
+	if (Next)
+	{
+		FSpecMapCache::Get().Preload(Next->TestMap);
+	}
+}
+
+bool FTestSpec::TickIsolatedWorld(float DeltaTime)
+{
+	if (IsolatedWorld)
+	{
+		IsolatedWorld->Tick(LEVELTICK_All, DeltaTime);
+	}
+	return true;
+}
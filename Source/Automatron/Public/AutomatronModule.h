@@ -11,10 +11,12 @@ class FAutomatronModule : public IModuleInterface
 {
 	static TArray<TSharedRef<FTestSpec>> SpecInstances;
 
+	FDelegateHandle OnAfterAllTestsHandle;
+
 public:
 
 	/** Begin IModuleInterface implementation */
-	virtual void StartupModule() override {}
-	virtual void ShutdownModule() override {}
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
 	/** End IModuleInterface implementation */
 };
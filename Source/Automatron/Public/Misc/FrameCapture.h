@@ -0,0 +1,87 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Engine/EngineBaseTypes.h>
+#include <UObject/WeakObjectPtr.h>
+
+class UWorld;
+
+
+// Records the duration of every tick of a world, along with any custom stats, while capturing.
+// Stat NAME_None is the frame time. All values are in milliseconds.
+// E.g:
+//   Capture.Start(GetWorld());
+//   ...some frames later...
+//   Capture.Stop();
+//   TestFrameBudget(Capture, 0.99, 33.0);
+class AUTOMATRON_API FSpecFrameCapture
+{
+public:
+
+	// Measures the duration of a scope into a stat of the current frame
+	struct AUTOMATRON_API FScopedStat
+	{
+		FScopedStat(FSpecFrameCapture& InCapture, FName InStat)
+			: Capture(InCapture), Stat(InStat), StartTime(FPlatformTime::Seconds())
+		{}
+		~FScopedStat();
+
+	private:
+		FSpecFrameCapture& Capture;
+		FName Stat;
+		double StartTime;
+	};
+
+private:
+
+	TWeakObjectPtr<UWorld> World;
+	FDelegateHandle TickHandle;
+	double LastTickTime = 0.0;
+
+	TArray<double> FrameTimes;
+
+	// Values of every stat, one per frame
+	TMap<FName, TArray<double>> Stats;
+
+	// Values added during the frame being captured
+	TMap<FName, double> FrameStats;
+
+	TMap<FName, TFunction<double()>> Samplers;
+
+
+public:
+
+	FSpecFrameCapture() = default;
+	FSpecFrameCapture(const FSpecFrameCapture&) = delete;
+	FSpecFrameCapture& operator=(const FSpecFrameCapture&) = delete;
+	~FSpecFrameCapture() { Stop(); }
+
+	// Starts capturing the ticks of World. Previously captured frames are discarded
+	void Start(UWorld* InWorld);
+	void Stop();
+
+	bool IsCapturing() const { return TickHandle.IsValid(); }
+	int32 GetNumFrames() const { return FrameTimes.Num(); }
+
+	// Adds to the value of a stat on the current frame. E.g: the cost of ticking a component
+	void AddStatValue(FName Stat, double Value);
+
+	// Reads the value of a stat at the end of every frame
+	void SampleStat(FName Stat, TFunction<double()> Getter);
+
+	const TArray<double>* GetValues(FName Stat = NAME_None) const;
+
+	// Percentile goes from 0 to 1. E.g: 0.99 ignores the slowest 1% of the frames
+	double GetPercentile(double Percentile, FName Stat = NAME_None) const;
+	double GetAverage(FName Stat = NAME_None) const;
+	double GetMax(FName Stat = NAME_None) const;
+
+	// One row per frame, one column per stat
+	bool SaveCsv(const FString& Path) const;
+
+private:
+
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+};
@@ -0,0 +1,101 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <UObject/WeakObjectPtr.h>
+
+class FSpecFrameCapture;
+class UGameInstance;
+class UNetDriver;
+class UWorld;
+
+
+// Network conditions simulated on every connection of a session.
+// Simulation needs net testing support (DO_ENABLE_NET_TEST), which shipping builds don't have.
+struct FSpecNetConditions
+{
+	// Latency added to every packet, in milliseconds
+	int32 LagMs = 0;
+	// Random variation of the latency, in milliseconds
+	int32 LagVarianceMs = 0;
+	// Percentage of packets dropped, from 0 to 100
+	int32 LossPercent = 0;
+
+	// If above zero, every world advances this much per frame instead of the real frame time.
+	// Applies to frames ticked by the session: Step, and every frame in the editor. See FSpecNetSession
+	float FixedDeltaSeconds = 0.f;
+
+	// Port the server listens on. Zero picks a free one, so that sessions of several processes don't collide
+	int32 Port = 0;
+};
+
+
+// A listen server and several clients running in this process, connected over local loopback.
+// The game engine ticks their worlds like any other game world. The editor doesn't, so there the session
+// ticks them together, server first, with the same delta time. See FTestSpec::NetClients
+class AUTOMATRON_API FSpecNetSession
+{
+	struct FInstance
+	{
+		UGameInstance* GameInstance = nullptr;
+		// Last driver the network conditions were applied to
+		TWeakObjectPtr<UNetDriver> ConditionedDriver;
+	};
+
+	FString Name;
+	FSpecNetConditions Conditions;
+
+	FInstance Server;
+	TArray<FInstance> Clients;
+
+	FDelegateHandle TickHandle;
+
+
+public:
+
+	// Bytes sent by the server on a frame, to all clients
+	static const FName OutBytesStat;
+	// Actor channels open on all connections of the server at the end of a frame
+	static const FName ActorChannelsStat;
+
+	// Bytes sent by the server to a single client on a frame. ClientIndex is the same as in GetClientWorld
+	static FName GetClientOutBytesStat(int32 ClientIndex);
+
+	FSpecNetSession(FString InName, const FSpecNetConditions& InConditions);
+	FSpecNetSession(const FSpecNetSession&) = delete;
+	FSpecNetSession& operator=(const FSpecNetSession&) = delete;
+	~FSpecNetSession();
+
+	// Loads Map as a listen server and starts connecting the clients. Game thread only
+	bool Start(const FString& Map, int32 NumClients, FString& OutError);
+	void Stop();
+
+	// True once every client joined the server and has a player controller
+	bool IsConnected() const;
+
+	// Port the server is listening on, or zero if it isn't
+	int32 GetServerPort() const;
+
+	UWorld* GetServerWorld() const;
+	UWorld* GetClientWorld(int32 ClientIndex) const;
+	int32 GetNumClients() const { return Clients.Num(); }
+
+	// Ticks all worlds a number of frames right away. Game thread only
+	void Step(int32 Frames, float DeltaSeconds);
+
+	// Samples the bandwidth stats of the server on every frame of a capture started on the server world
+	void CaptureBandwidth(FSpecFrameCapture& Capture) const;
+
+	// True if the world belongs to any session. Other specs must not use it
+	static bool IsSessionWorld(const UWorld* World);
+
+private:
+
+	UGameInstance* CreateInstance(const FString& InstanceName);
+	void DestroyInstance(FInstance& Instance);
+
+	bool Tick(float DeltaTime);
+	void TickInstance(FInstance& Instance, float DeltaSeconds);
+	void ApplyConditions(FInstance& Instance);
+};
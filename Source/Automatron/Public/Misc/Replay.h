@@ -0,0 +1,143 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Engine/EngineBaseTypes.h>
+#include <UObject/WeakObjectPtr.h>
+
+class UWorld;
+
+
+// Receives the inputs of a replay, to apply them to the world before the frame ticks
+using FSpecReplayInputHandler = TFunction<void(FName Channel, float Value)>;
+
+
+// Inputs a test applied to a world on every frame, along with the frame times and hashes of the initial and final states.
+// Playing it back applies the same inputs before the same frames, so a deterministic world ends in the same state.
+class AUTOMATRON_API FSpecReplay
+{
+	struct FInput
+	{
+		int32 Channel;
+		float Value;
+	};
+
+	TArray<FName> Channels;
+
+	// One per frame
+	TArray<float> DeltaSeconds;
+	TArray<int32> FirstInputs;
+
+	TArray<FInput> Inputs;
+
+	uint64 InitialStateHash = 0;
+	uint64 FinalStateHash = 0;
+
+
+public:
+
+	int32 GetNumFrames() const { return DeltaSeconds.Num(); }
+	uint64 GetInitialStateHash() const { return InitialStateHash; }
+	uint64 GetFinalStateHash() const { return FinalStateHash; }
+
+	void AddFrame(float InDeltaSeconds, const TArray<TPair<FName, float>>& FrameInputs);
+	void SetInitialStateHash(uint64 Hash) { InitialStateHash = Hash; }
+	void SetFinalStateHash(uint64 Hash) { FinalStateHash = Hash; }
+
+	// Applies the inputs of a frame through the handler
+	void ApplyInputs(int32 Frame, const FSpecReplayInputHandler& Handler) const;
+	float GetDeltaSeconds(int32 Frame) const { return DeltaSeconds[Frame]; }
+
+	// Compact binary format. Counts and channels are packed, values are stored as floats
+	bool Save(const FString& Path) const;
+	bool Load(const FString& Path);
+
+	// Hash of the classes and transforms of all actors, independent of their order and names
+	static uint64 HashWorldState(UWorld* World);
+
+private:
+
+	int32 FindOrAddChannel(FName Channel);
+	void Serialize(FArchive& Ar);
+};
+
+
+// Records the inputs applied to a world and the duration of its frames while recording
+class AUTOMATRON_API FSpecReplayRecorder
+{
+	TWeakObjectPtr<UWorld> World;
+	FDelegateHandle TickHandle;
+
+	FSpecReplay Replay;
+
+	// Applied since the last tick. Recorded with the next one
+	TArray<TPair<FName, float>> PendingInputs;
+
+
+public:
+
+	FSpecReplayRecorder() = default;
+	FSpecReplayRecorder(const FSpecReplayRecorder&) = delete;
+	FSpecReplayRecorder& operator=(const FSpecReplayRecorder&) = delete;
+	~FSpecReplayRecorder() { Stop(); }
+
+	// Starts a new recording of World from its current state. Game thread only
+	void Start(UWorld* InWorld);
+
+	// Hashes the final state of the world. Inputs applied after the last tick are dropped
+	FSpecReplay Stop();
+
+	bool IsRecording() const { return TickHandle.IsValid(); }
+
+	void RecordInput(FName Channel, float Value);
+
+private:
+
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+};
+
+
+// Plays a replay back on a world as the engine ticks it, one recorded frame per engine frame.
+// Inputs of a frame are applied when its tick starts. The engine runs on a fixed time step with the
+// recorded frame times until the replay ends, so ticks last as long as when recorded
+class AUTOMATRON_API FSpecReplayPlayer
+{
+	TWeakObjectPtr<UWorld> World;
+	FDelegateHandle TickHandle;
+	FDelegateHandle BeginFrameHandle;
+
+	FSpecReplay Replay;
+	FSpecReplayInputHandler InputHandler;
+	TFunction<void()> OnFinished;
+
+	// Frame applied on the next tick of the world. Frames are only played once an engine frame begins
+	int32 Frame = 0;
+	bool bStarted = false;
+
+	bool bPreviousUseFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+
+
+public:
+
+	FSpecReplayPlayer() = default;
+	FSpecReplayPlayer(const FSpecReplayPlayer&) = delete;
+	FSpecReplayPlayer& operator=(const FSpecReplayPlayer&) = delete;
+	~FSpecReplayPlayer() { Stop(); }
+
+	// Plays from the next engine frame. OnFinished is called on the frame after the last one played,
+	// once the world ticked it. Game thread only
+	void Start(UWorld* InWorld, FSpecReplay&& InReplay, FSpecReplayInputHandler InInputHandler, TFunction<void()> InOnFinished);
+
+	// Restores the time step of the engine. OnFinished is not called
+	void Stop();
+
+	bool IsPlaying() const { return BeginFrameHandle.IsValid(); }
+	const FSpecReplay& GetReplay() const { return Replay; }
+
+private:
+
+	void OnBeginFrame();
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+};
@@ -8,31 +8,16 @@
 #include <Tests/AutomationCommon.h>
 #include <Templates/UnrealTypeTraits.h>
 
-#include "Base/TestSpecBase.h"
+#include "CoreTestSpec.h"
+#include "Misc/FrameCapture.h"
+#include "Misc/NetSession.h"
+#include "Misc/Replay.h"
 
 
 DECLARE_DELEGATE_OneParam(FSpecBaseOnWorldReady, UWorld*);
 
-// Initializes an spec instance at global execution time
-// and registers it to the system
-template<typename T>
-struct TSpecRegister
-{
-    static TSpecRegister<T> Register;
-
-    T Instance;
-
-    TSpecRegister() : Instance{}
-    {
-        Instance.Setup();
-    }
-};
-
-template<typename T>
-TSpecRegister<T> TSpecRegister<T>::Register{};
-
 
-class AUTOMATRON_API FTestSpec : public FTestSpecBase
+class AUTOMATRON_API FTestSpec : public FCoreTestSpec
 {
 public:
 
@@ -45,13 +30,24 @@ public:
 	// If true and in editor, a PIE instance will be used to test
 	bool bCanUsePIEWorld = true;
 
-private:
+	// If true the spec creates its own game world instead of using PIE or the first game world, so specs don't
+	// share or fight over it. Specs still run one at a time.
+	bool bUseIsolatedWorld = false;
+
+	// Map package the spec runs on. E.g: "/Game/Maps/TestMap"
+	// Implies an isolated world, created from the map. Maps are cached across specs and
+	// the map of the next spec is loaded in the background while this one runs.
+	FString TestMap;
+
+	// If above zero, the spec runs on a listen server and this many clients, all created in this process
+	// and connected over local loopback. The server loads TestMap, or an empty map if not set.
+	// GetWorld() returns the server world. See GetClientWorld, StepNetWorlds
+	int32 NetClients = 0;
 
-	FString ClassName;
-	FString PrettyName;
-	FString FileName;
-	int32 LineNumber = -1;
-	uint32 Flags = 0;
+	// Simulated latency and packet loss of every connection when NetClients is used
+	FSpecNetConditions NetConditions;
+
+private:
 
 	bool bInitializedWorld = false;
 #if WITH_EDITOR
@@ -60,70 +56,120 @@ private:
 
 	TWeakObjectPtr<UWorld> World;
 
+	UWorld* IsolatedWorld = nullptr;
+	// Owns the context of the isolated world, so that it plays like any game world
+	UGameInstance* IsolatedGameInstance = nullptr;
+	FDelegateHandle IsolatedWorldTickHandle;
 
-public:
-
-	FTestSpec() : FTestSpecBase("", false) {}
+	TUniquePtr<FSpecNetSession> NetSession;
 
-	virtual FString GetTestSourceFileName() const override { return FileName; }
-	virtual int32 GetTestSourceFileLine() const override { return LineNumber; }
-	virtual uint32 GetTestFlags() const override { return Flags; }
+	FSpecReplayRecorder ReplayRecorder;
+	FSpecReplayInputHandler RecordingInputHandler;
+	FSpecReplayPlayer ReplayPlayer;
 
-	const FString& GetClassName() const { return ClassName; }
-	const FString& GetPrettyName() const { return PrettyName; }
 
-protected:
+public:
 
-	virtual FString GetBeautifiedTestName() const override { return PrettyName; }
+	FTestSpec();
+	virtual ~FTestSpec();
 
-	template<uint32 TFlags>
-	void Setup(FString&& InName, FString&& InPrettyName, FString&& InFileName, int32 InLineNumber);
+	virtual bool RunTest(const FString& InParameters) override;
 
-	// Used to indicate a test is pending to be implemented.
-	void TestNotImplemented()
-	{
-		AddWarning(TEXT("Test not implemented"), 1);
-	}
+protected:
 
 	virtual void PreDefine() override;
 	virtual void PostDefine() override;
+	virtual void OnFailFast() override;
+
+	// Specs using a world depend on content and engine state, so they always run
+	virtual bool CanCacheResults() const override { return !bUseWorld; }
+
+	// The world has to keep ticking while tests wait
+	virtual bool CanSleepWhileWaiting() const override { return !bUseWorld; }
 
 	void PrepareTestWorld(FSpecBaseOnWorldReady OnWorldReady);
 	void ReleaseTestWorld();
 
 	UWorld* GetWorld() const { return World.Get(); }
 
-private:
+	// BEGIN Networking (NetClients)
+	UWorld* GetClientWorld(int32 ClientIndex) const;
+	int32 GetNumClientWorlds() const;
 
-	void Reregister(const FString& NewName)
+	// Ticks the server and all clients in lockstep a number of frames, right away. Game thread only
+	void StepNetWorlds(int32 Frames, float DeltaSeconds = 1.f / 60.f);
+
+	// Adds bandwidth stats to a capture of the server world. See FSpecNetSession::OutBytesStat
+	void CaptureNetBandwidth(FSpecFrameCapture& Capture) const;
+
+	// Fails if the given percentile (0 to 1) of the bytes sent per frame goes over budget
+	bool TestNetBandwidth(const FSpecFrameCapture& Capture, double Percentile, double BudgetBytes, FName Stat = FSpecNetSession::OutBytesStat);
+	// END Networking
+
+	// BEGIN Record and replay
+	// Records the inputs passed to ApplyInput and the frame times of the world, until StopRecording.
+	// Inputs are applied through the handler, which is how the replay will apply them too.
+	// Playback must start from the same state the world is in now
+	void StartRecording(FSpecReplayInputHandler InputHandler);
+
+	// Saves the recording with the hash of the final world state as "Replays/<TestName>/<Name>.replay" next to the spec source file
+	bool StopRecording(const FString& Name);
+
+	// Applies an input before the next frame, recording it if recording
+	void ApplyInput(FName Channel, float Value);
+
+	// Plays a replay back from a LatentIt, one recorded frame per engine frame, applying the recorded inputs.
+	// Fails if the world doesn't start in the recorded state or ends in a different one. Done is called either way.
+	// Frame cost can be measured with a FSpecFrameCapture. See FSpecReplayPlayer
+	// E.g: LatentIt("Jumps", [this](const FDoneDelegate& Done) { PlayReplay("Jump", InputHandler, Done); });
+	void PlayReplay(const FString& Name, FSpecReplayInputHandler InputHandler, const FDoneDelegate& Done);
+	// END Record and replay
+
+	// BEGIN Frame budget expectations
+	// Fails if the given percentile (0 to 1) of a captured stat goes over budget. 1 checks the slowest frame
+	bool TestFrameBudget(const FSpecFrameCapture& Capture, double Percentile, double BudgetMs, FName Stat = NAME_None);
+
+	bool TestAverageBudget(const FSpecFrameCapture& Capture, double BudgetMs, FName Stat = NAME_None);
+
+	// Saves captured frames as "<FrameCaptureDir>/<ClassName>/<Name>.csv"
+	void ExportFrameCapture(const FSpecFrameCapture& Capture, const FString& Name);
+
+	// LatentIt capturing the frames of the world while its body runs. Once it is done or times out, the capture
+	// is stopped, exported as "<Description>.csv" and, if the test didn't fail, checked by CheckBudgets
+	// E.g: CapturedLatentIt("Explosions", DoWork, [this](const FSpecFrameCapture& Capture) { TestFrameBudget(Capture, 0.99, 33.0); });
+	void CapturedLatentIt(const FString& InDescription, TFunction<void(FSpecFrameCapture&, const FDoneDelegate&)> DoWork, TFunction<void(const FSpecFrameCapture&)> CheckBudgets);
+	void CapturedLatentIt(const FString& InDescription, const FTimespan& Timeout, TFunction<void(FSpecFrameCapture&, const FDoneDelegate&)> DoWork, TFunction<void(const FSpecFrameCapture&)> CheckBudgets);
+	// END Frame budget expectations
+
+	using FTestSpecBase::TestMatchesSnapshot;
+
+	// Snapshot of the properties of a struct. Mismatches are reported by property
+	template<typename TStruct>
+	bool TestMatchesSnapshot(const FString& Name, const TStruct& Value)
 	{
-		FAutomationTestFramework::Get().UnregisterAutomationTest(TestName);
-		TestName = NewName;
-		FAutomationTestFramework::Get().RegisterAutomationTest(TestName, this);
+		return TestMatchesSnapshot(Name, TStruct::StaticStruct(), &Value);
 	}
+	bool TestMatchesSnapshot(const FString& Name, const UScriptStruct* Struct, const void* Value);
+
+private:
 
-	// Finds the first available game world (Standalone or PIE)
+	// Finds the first available game world (Standalone or PIE). Isolated worlds of other specs are ignored
 	static UWorld* FindGameWorld();
-};
 
+	bool UsesIsolatedWorld() const { return bUseIsolatedWorld || !TestMap.IsEmpty() || NetClients > 0; }
+
+	FString GetReplayPath(const FString& Name) const;
+
+	// Starts loading the map of the spec running after this one
+	void PreloadNextMap() const;
+
+	UWorld* CreateIsolatedWorld();
+	void DestroyIsolatedWorld();
+
+	UWorld* StartNetSession();
+	void StopNetSession();
+	// Waits off the game thread until all clients joined or the timeout expires
+	bool WaitForNetClients() const;
+	bool TickIsolatedWorld(float DeltaTime);
+};
 
-template<uint32 TFlags>
-inline void FTestSpec::Setup(FString&& InName, FString&& InPrettyName, FString&& InFileName, int32 InLineNumber)
-{
-	static_assert(TFlags & EAutomationTestFlags::ApplicationContextMask, "AutomationTest has no application flag. It shouldn't run. See AutomationTest.h."); \
-	static_assert(((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::SmokeFilter) ||
-		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::EngineFilter) ||
-		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::ProductFilter) ||
-		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::PerfFilter) ||
-		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::StressFilter) ||
-		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::NegativeFilter),
-		"All AutomationTests must have exactly 1 filter type specified.  See AutomationTest.h.");
-
-	ClassName = InName;
-	PrettyName = MoveTemp(InPrettyName);
-	FileName = MoveTemp(InFileName);
-	LineNumber = InLineNumber;
-	Flags = TFlags;
-
-	Reregister(InName);
-}
@@ -0,0 +1,30 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class AutomatronCore : ModuleRules
+{
+	public AutomatronCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		bEnforceIWYU = true;
+		bLegacyPublicIncludePaths = false;
+
+		// Only Core, so that specs of low level code build and start fast
+		PublicDependencyModuleNames.AddRange(new string[]
+		{
+			"Core"
+		});
+
+		PrivateDependencyModuleNames.AddRange(new string[]
+		{
+			"Json"
+		});
+
+		// Specs are redefined after Live Coding patches
+		if (Target.bWithLiveCoding)
+		{
+			PrivateIncludePathModuleNames.Add("LiveCoding");
+		}
+	}
+}
@@ -0,0 +1,7 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AutomatronCore.h"
+#include "Misc/Log.h"
+
+
+DEFINE_LOG_CATEGORY(LogAutomatron);
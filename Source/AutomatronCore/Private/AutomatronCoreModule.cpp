@@ -0,0 +1,84 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AutomatronCoreModule.h"
+#include <Misc/AutomationTest.h>
+
+#include "Base/TestSpecBase.h"
+#include "Misc/BakeReport.h"
+#include "Misc/HangWatchdog.h"
+#include "Misc/ImpactMap.h"
+#include "Misc/LogCapture.h"
+#include "Misc/ResultCache.h"
+#include "Misc/ResultReporter.h"
+#include "Misc/RunHistory.h"
+#include "Misc/RunStats.h"
+
+#if WITH_LIVE_CODING
+#include <ILiveCodingModule.h>
+#endif
+
+#define LOCTEXT_NAMESPACE "FAutomatronCoreModule"
+
+
+void FAutomatronCoreModule::StartupModule()
+{
+	GLog->AddOutputDevice(&FSpecLogCapture::Get());
+
+	FAutomationTestFramework& Framework = FAutomationTestFramework::Get();
+	OnBeforeAllTestsHandle = Framework.OnBeforeAllTestsEvent.AddLambda([]()
+	{
+		FAutomatronRunStats::Get().Reset();
+		FSpecResultReporter::Get().Begin();
+	});
+	OnAfterAllTestsHandle = Framework.OnAfterAllTestsEvent.AddLambda([]()
+	{
+		FAutomatronRunStats::Get().Report();
+		FSpecImpactMap::Get().Save();
+		FSpecResultCache::Get().Save();
+		FSpecResultReporter::Get().End();
+		FSpecRunHistory::Get().Save();
+		FSpecBakeReport::Get().Save();
+	});
+
+	// Hot reload loads a new binary of the module. Its specs are baked again on next use
+	OnModulesChangedHandle = FModuleManager::Get().OnModulesChanged().AddLambda([](FName ModuleName, EModuleChangeReason Reason)
+	{
+		if (Reason == EModuleChangeReason::ModuleLoaded)
+		{
+			FTestSpecBase::RedefineModule(ModuleName.ToString());
+		}
+	});
+
+#if WITH_LIVE_CODING
+	// Patches don't tell which modules changed, so all specs are redefined. Each one is baked again on next use
+	if (ILiveCodingModule* LiveCoding = FModuleManager::LoadModulePtr<ILiveCodingModule>(LIVE_CODING_MODULE_NAME))
+	{
+		OnPatchCompleteHandle = LiveCoding->GetOnPatchCompleteDelegate().AddStatic(&FTestSpecBase::RedefineAll);
+	}
+#endif
+}
+
+void FAutomatronCoreModule::ShutdownModule()
+{
+	if (GLog)
+	{
+		GLog->RemoveOutputDevice(&FSpecLogCapture::Get());
+	}
+	FSpecHangWatchdog::Get().Shutdown();
+
+	FAutomationTestFramework& Framework = FAutomationTestFramework::Get();
+	Framework.OnBeforeAllTestsEvent.Remove(OnBeforeAllTestsHandle);
+	Framework.OnAfterAllTestsEvent.Remove(OnAfterAllTestsHandle);
+
+	FModuleManager::Get().OnModulesChanged().Remove(OnModulesChangedHandle);
+#if WITH_LIVE_CODING
+	if (ILiveCodingModule* LiveCoding = FModuleManager::GetModulePtr<ILiveCodingModule>(LIVE_CODING_MODULE_NAME))
+	{
+		LiveCoding->GetOnPatchCompleteDelegate().Remove(OnPatchCompleteHandle);
+	}
+#endif
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FAutomatronCoreModule, AutomatronCore)
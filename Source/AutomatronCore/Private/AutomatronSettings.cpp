@@ -0,0 +1,137 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AutomatronSettings.h"
+#include <Misc/CommandLine.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Parse.h>
+#include <Misc/Paths.h>
+
+#include "Misc/Log.h"
+
+
+const FAutomatronSettings& FAutomatronSettings::Get()
+{
+	static FAutomatronSettings Settings = []()
+	{
+		FAutomatronSettings NewSettings;
+		NewSettings.Parse(FCommandLine::Get());
+		return NewSettings;
+	}();
+	return Settings;
+}
+
+bool FAutomatronSettings::MatchesAny(const TArray<FString>& Selectors, const FString& SpecId)
+{
+	for (const FString& Selector : Selectors)
+	{
+		if (Selector.EndsWith(TEXT("*")))
+		{
+			if (SpecId.StartsWith(Selector.LeftChop(1)))
+			{
+				return true;
+			}
+		}
+		else if (SpecId == Selector)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FAutomatronSettings::Parse(const TCHAR* CommandLine)
+{
+	FString StressList;
+	if (FParse::Value(CommandLine, TEXT("-Automatron.Stress="), StressList, false))
+	{
+		StressList.TrimQuotesInline();
+		StressList.ParseIntoArray(StressSpecs, TEXT(","));
+		for (FString& Selector : StressSpecs)
+		{
+			Selector.TrimStartAndEndInline();
+		}
+	}
+	FParse::Value(CommandLine, TEXT("-Automatron.StressRuns="), StressRuns);
+	FParse::Value(CommandLine, TEXT("-Automatron.StressSeconds="), StressSeconds);
+	FParse::Value(CommandLine, TEXT("-Automatron.StressSeed="), StressSeed);
+	bStressShuffle = FParse::Param(CommandLine, TEXT("Automatron.StressShuffle"));
+
+	// A selected spec without a limit runs once, which wouldn't stress anything
+	if (StressSpecs.Num() > 0 && StressRuns <= 0 && StressSeconds <= 0.0)
+	{
+		StressRuns = 100;
+	}
+
+	FParse::Value(CommandLine, TEXT("-Automatron.MaxFailures="), MaxFailures);
+	if (MaxFailures <= 0 && FParse::Param(CommandLine, TEXT("Automatron.FailFast")))
+	{
+		MaxFailures = 1;
+	}
+
+	FString FailFastScope;
+	if (FParse::Value(CommandLine, TEXT("-Automatron.FailFastScope="), FailFastScope))
+	{
+		bFailFastWholeRun = FailFastScope != TEXT("Spec");
+	}
+
+	FParse::Value(CommandLine, TEXT("-Automatron.ImpactMap="), ImpactMapFile);
+	FParse::Value(CommandLine, TEXT("-Automatron.ChangedFiles="), ChangedFilesFile);
+	FParse::Value(CommandLine, TEXT("-Automatron.RecordImpactMap="), RecordImpactMapFile);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.Tags="), TagQuery, false);
+	TagQuery.TrimQuotesInline();
+
+	bResultCache = FParse::Param(CommandLine, TEXT("Automatron.ResultCache"));
+	bForceRun = FParse::Param(CommandLine, TEXT("Automatron.ForceRun"));
+	ResultCacheFile = FPaths::ProjectSavedDir() / TEXT("Automation") / TEXT("AutomatronResultCache.txt");
+	FParse::Value(CommandLine, TEXT("-Automatron.ResultCacheFile="), ResultCacheFile);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.JUnit="), JUnitReportFile);
+	FParse::Value(CommandLine, TEXT("-Automatron.JsonReport="), JsonReportFile);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.History="), HistoryFile);
+	FParse::Value(CommandLine, TEXT("-Automatron.HistoryRuns="), HistoryRuns);
+	FParse::Value(CommandLine, TEXT("-Automatron.RegressionDeviations="), RegressionDeviations);
+	FParse::Value(CommandLine, TEXT("-Automatron.RegressionMinChange="), RegressionMinChange);
+	FParse::Value(CommandLine, TEXT("-Automatron.RegressionReport="), RegressionReportFile);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.BakeReport="), BakeReportFile);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.LogCaptureCapacity="), LogCaptureCapacity);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.IdleSleepMs="), IdleSleepMs);
+	FParse::Value(CommandLine, TEXT("-Automatron.IdleFrameRate="), IdleFrameRate);
+
+	FrameCaptureDir = FPaths::ProjectSavedDir() / TEXT("Automation") / TEXT("FrameCaptures");
+	FParse::Value(CommandLine, TEXT("-Automatron.FrameCaptureDir="), FrameCaptureDir);
+
+	bUpdateSnapshots = FParse::Param(CommandLine, TEXT("Automatron.UpdateSnapshots"));
+
+	FParse::Value(CommandLine, TEXT("-Automatron.MapCacheMB="), MapCacheMB);
+
+	FParse::Value(CommandLine, TEXT("-Automatron.HangDumpFraction="), HangDumpFraction);
+
+	QuarantineFile = FPaths::ProjectConfigDir() / TEXT("AutomatronQuarantine.txt");
+	FParse::Value(CommandLine, TEXT("-Automatron.Quarantine="), QuarantineFile);
+	LoadQuarantine();
+}
+
+void FAutomatronSettings::LoadQuarantine()
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *QuarantineFile))
+	{
+		return;
+	}
+
+	for (FString& Line : Lines)
+	{
+		Line.TrimStartAndEndInline();
+		// Lines starting with '#' are comments
+		if (!Line.IsEmpty() && !Line.StartsWith(TEXT("#")))
+		{
+			QuarantinedSpecs.Add(MoveTemp(Line));
+		}
+	}
+	UE_LOG(LogAutomatron, Log, TEXT("Loaded %i quarantined specs from '%s'"), QuarantinedSpecs.Num(), *QuarantineFile);
+}
@@ -0,0 +1,1398 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Base/TestSpecBase.h"
+#include <Math/RandomStream.h>
+#include <Misc/App.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/BakeReport.h"
+#include "Misc/HangWatchdog.h"
+#include "Misc/ImpactMap.h"
+#include "Misc/Log.h"
+#include "Misc/LogCapture.h"
+#include "Misc/ResultCache.h"
+#include "Misc/ResultReporter.h"
+#include "Misc/RunHistory.h"
+#include "Misc/RunStats.h"
+#include "Misc/Snapshot.h"
+#include "Misc/SpecTags.h"
+
+
+namespace
+{
+	// Percentile of an ascending sorted array
+	double GetPercentile(const TArray<double>& SortedValues, double Percentile)
+	{
+		if (SortedValues.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+		return SortedValues[Index];
+	}
+
+	// Auto-reset, so a wake up is consumed by the next sleep even if it happened before it
+	FEvent* GetWakeUpEvent()
+	{
+		static FEvent* Event = FPlatformProcess::GetSynchEventFromPool(false);
+		return Event;
+	}
+}
+
+bool FTestSpecBase::FSingleExecuteLatentCommand::Update()
+{
+	if (bSkipIfErrored && Spec->HasAnyErrorsThreadSafe())
+	{
+		return true;
+	}
+
+	Predicate();
+	return true;
+}
+
+
+bool FTestSpecBase::FUntilDoneLatentCommand::Update()
+{
+	if (!bIsRunning)
+	{
+		if (bSkipIfErrored && Spec->HasAnyErrorsThreadSafe())
+		{
+			return true;
+		}
+
+		Predicate(FDoneDelegate::CreateSP(this, &FUntilDoneLatentCommand::Done, Generation.GetValue()));
+		bIsRunning = true;
+		StartedRunning = FDateTime::UtcNow();
+		Spec->BeginHangWatch(Timeout);
+	}
+
+	if (bDone)
+	{
+		Reset();
+		return true;
+	}
+	else if (bSkipIfErrored && Spec->IsFailingFast())
+	{
+		// Stop waiting. Late completions of this run will be ignored
+		Reset();
+		return true;
+	}
+	else if (FDateTime::UtcNow() >= StartedRunning + Timeout)
+	{
+		Spec->AddTimeoutError();
+		Reset();
+		return true;
+	}
+
+	return false;
+}
+
+
+bool FTestSpecBase::FAsyncUntilDoneLatentCommand::Update()
+{
+	if (!Future.IsValid())
+	{
+		if (bSkipIfErrored && Spec->HasAnyErrorsThreadSafe())
+		{
+			return true;
+		}
+
+		StartedRunning = FDateTime::UtcNow();
+		const uint32 WatchId = Spec->BeginHangWatch(Timeout);
+		Future = Async(Execution, [this, CurrentGeneration = Generation.GetValue(), WatchId]() {
+			FTestSpecBase::WatchCurrentThread(WatchId);
+			Predicate(FDoneDelegate::CreateRaw(this, &FAsyncUntilDoneLatentCommand::Done, CurrentGeneration));
+		});
+	}
+
+	if (bDone)
+	{
+		Reset();
+		return true;
+	}
+	else if (bSkipIfErrored && Future.IsReady() && Spec->IsFailingFast())
+	{
+		// The body returned and only its done delegate is pending. Late completions of this run will be ignored
+		Reset();
+		return true;
+	}
+	else if (FDateTime::UtcNow() >= StartedRunning + Timeout)
+	{
+		Spec->AddTimeoutError();
+		Reset();
+		return true;
+	}
+	return false;
+}
+
+
+bool FTestSpecBase::FAsyncLatentCommand::Update()
+{
+	if (!Future.IsValid())
+	{
+		if (bSkipIfErrored && Spec->HasAnyErrorsThreadSafe())
+		{
+			return true;
+		}
+
+		StartedRunning = FDateTime::UtcNow();
+		const uint32 WatchId = Spec->BeginHangWatch(Timeout);
+		Future = Async(Execution, [this, CurrentGeneration = Generation.GetValue(), WatchId]() {
+			FTestSpecBase::WatchCurrentThread(WatchId);
+			Predicate();
+			Done(CurrentGeneration);
+		});
+	}
+
+	// Running bodies are waited for even when failing fast, so that AfterEach doesn't tear down what they use
+	if (bDone)
+	{
+		Reset();
+		return true;
+	}
+	else if (FDateTime::UtcNow() >= StartedRunning + Timeout)
+	{
+		Spec->AddTimeoutError();
+		Reset();
+		return true;
+	}
+
+	return false;
+}
+
+
+bool FTestSpecBase::FFusedAsyncLatentCommand::Update()
+{
+	if (!Future.IsValid())
+	{
+		FTimespan TotalTimeout;
+		for (const TSharedRef<FAsyncLatentCommand>& Step : Steps)
+		{
+			TotalTimeout += Step->Timeout;
+		}
+
+		CurrentStep.Set(0);
+		StepStartedCycles.Set(FPlatformTime::Cycles64());
+		const uint32 WatchId = Spec->BeginHangWatch(TotalTimeout);
+		Future = Async(Execution, [this, CurrentGeneration = Generation.GetValue(), WatchId]() {
+			FTestSpecBase::WatchCurrentThread(WatchId);
+			for (int32 Index = 0; Index < Steps.Num(); ++Index)
+			{
+				// Abandoned. Don't run the remaining steps
+				if (CurrentGeneration != Generation.GetValue())
+				{
+					return;
+				}
+
+				const FAsyncLatentCommand& Step = *Steps[Index];
+				if (Step.bSkipIfErrored && Spec->HasAnyErrorsThreadSafe())
+				{
+					continue;
+				}
+
+				StepStartedCycles.Set(FPlatformTime::Cycles64());
+				CurrentStep.Set(Index);
+				Step.Predicate();
+			}
+			Done(CurrentGeneration);
+		});
+	}
+
+	const FAsyncLatentCommand& Step = *Steps[CurrentStep.GetValue()];
+	const double StepSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StepStartedCycles.GetValue());
+	// Running steps are waited for even when failing fast. Steps left skip themselves on errors
+	if (bDone)
+	{
+		Reset();
+		return true;
+	}
+	else if (StepSeconds >= Step.Timeout.GetTotalSeconds())
+	{
+		Spec->AddTimeoutError();
+		Reset();
+		return true;
+	}
+
+	return false;
+}
+
+
+bool FTestSpecBase::FRunSpecLatentCommand::Update()
+{
+	if (!bIsRunning)
+	{
+		if (Result.AttemptDurations.Num() == 0 && Spec->HasReachedMaxFailures())
+		{
+			// Fail-fast stopped this spec before it started, so there's nothing to clean up
+			Spec->ReportSkipped(*SpecToRun, TEXT("Skipped by fail-fast"));
+			LastResult = {};
+			return true;
+		}
+		StartAttempt();
+	}
+
+	Spec->MergePendingEvents();
+
+	const TArray<TSharedRef<IAutomationLatentCommand>>& Commands = SpecToRun->Commands;
+	while (CommandIndex < Commands.Num())
+	{
+		if (!Commands[CommandIndex]->Update())
+		{
+			Spec->SleepWhileWaiting();
+			return false;
+		}
+		++CommandIndex;
+	}
+
+	// Async bodies are done. Anything they reported belongs to this attempt
+	Spec->MergePendingEvents();
+
+	if (FinishAttempt())
+	{
+		// Retry on the next frame
+		return false;
+	}
+
+	Finish();
+	return true;
+}
+
+void FTestSpecBase::FRunSpecLatentCommand::StartAttempt()
+{
+	if (Result.AttemptDurations.Num() == 0 && Spec->LogCaptureLines > 0)
+	{
+		LogTag = FSpecLogCapture::Get().BeginTest();
+	}
+
+	bIsRunning = true;
+	CommandIndex = 0;
+	StartedRunning = FPlatformTime::Seconds();
+	EntriesBeforeAttempt = Spec->ExecutionInfo.GetEntries().Num();
+	const bool bLastAttempt = Result.AttemptDurations.Num() >= SpecToRun->Options.MaxRetries;
+	Spec->bFailureReachesMaxFailures = bLastAttempt && !Spec->IsQuarantined(SpecToRun->Id) && Spec->HasReachedMaxFailures(1);
+	if (Result.AttemptDurations.Num() == 0)
+	{
+		EntriesBeforeFirstAttempt = EntriesBeforeAttempt;
+	}
+	ErrorsBeforeAttempt = Spec->ExecutionInfo.GetErrorTotal();
+	ContextBeforeAttempt = Spec->CurrentContext;
+}
+
+bool FTestSpecBase::FRunSpecLatentCommand::FinishAttempt()
+{
+	const double Duration = FPlatformTime::Seconds() - StartedRunning;
+	Result.AttemptDurations.Add(Duration);
+	bIsRunning = false;
+
+	Result.bPassed = Spec->ExecutionInfo.GetErrorTotal() <= ErrorsBeforeAttempt;
+	const int32 Attempt = Result.AttemptDurations.Num();
+	if (Result.bPassed || Attempt > SpecToRun->Options.MaxRetries)
+	{
+		return false;
+	}
+
+	// Keep the failure as a warning and try again
+	const TArray<FString> Errors = Spec->ExtractErrorsSince(EntriesBeforeAttempt);
+	for (const FString& Error : Errors)
+	{
+		Spec->AddWarning(FString::Printf(TEXT("Attempt %i failed (%.3fs): %s"), Attempt, Duration, *Error), 0);
+	}
+
+	FAutomatronRunStats& Stats = FAutomatronRunStats::Get();
+	++Stats.Retries;
+	Stats.RetriedSeconds += Duration;
+
+	// A retry is the same test again, not the next one
+	Spec->CurrentContext = ContextBeforeAttempt;
+	return true;
+}
+
+void FTestSpecBase::FRunSpecLatentCommand::Finish()
+{
+	FSpecReport Report;
+	const bool bReport = FSpecResultReporter::Get().IsEnabled();
+	if (bReport)
+	{
+		// Before failure logs and quarantine change the entries of the test.
+		// Failed attempts that were retried are kept as warnings
+		const TArray<FAutomationExecutionEntry>& Entries = Spec->ExecutionInfo.GetEntries();
+		for (int32 Index = EntriesBeforeFirstAttempt; Index < Entries.Num(); ++Index)
+		{
+			const FAutomationEvent& Event = Entries[Index].Event;
+			if (Event.Type == EAutomationEventType::Error)
+			{
+				Report.Errors.Add(Event.Message);
+			}
+			else if (Event.Type == EAutomationEventType::Warning)
+			{
+				Report.Warnings.Add(Event.Message);
+			}
+		}
+	}
+
+	if (LogTag != 0)
+	{
+		FSpecLogCapture& LogCapture = FSpecLogCapture::Get();
+		LogCapture.EndTest();
+
+		// Only failed tests pay for copying their log
+		if (!Result.bPassed)
+		{
+			const TArray<FString> Lines = LogCapture.GetLines(LogTag, Spec->LogCaptureVerbosity, Spec->LogCaptureLines);
+			if (Lines.Num() > 0)
+			{
+				Spec->AddInfo(FString::Printf(TEXT("Log of the failed test (last %i lines):"), Lines.Num()));
+				for (const FString& Line : Lines)
+				{
+					Spec->AddInfo(Line);
+				}
+			}
+		}
+		LogTag = 0;
+	}
+
+	const int32 Attempts = Result.AttemptDurations.Num();
+	if (Result.PassedOnRetry())
+	{
+		Spec->AddWarning(FString::Printf(TEXT("Passed on retry (attempt %i of %i)"), Attempts, SpecToRun->Options.MaxRetries + 1), 0);
+		++FAutomatronRunStats::Get().PassedOnRetry;
+	}
+	if (Attempts > 1)
+	{
+		for (int32 Index = 0; Index < Attempts; ++Index)
+		{
+			Spec->AddInfo(FString::Printf(TEXT("Attempt %i took %.3fs"), Index + 1, Result.AttemptDurations[Index]));
+		}
+	}
+
+	Result.bQuarantined = Spec->IsQuarantined(SpecToRun->Id);
+	if (Result.bQuarantined && !Result.bPassed)
+	{
+		const TArray<FString> Errors = Spec->ExtractErrorsSince(EntriesBeforeAttempt);
+		for (const FString& Error : Errors)
+		{
+			Spec->AddWarning(FString::Printf(TEXT("[Quarantined] %s"), *Error), 0);
+		}
+		++FAutomatronRunStats::Get().QuarantinedFailures;
+	}
+	else if (!Result.bPassed)
+	{
+		FAutomatronRunStats& Stats = FAutomatronRunStats::Get();
+		++Stats.Failures;
+		++Stats.FailuresBySpec.FindOrAdd(Spec->TestName);
+
+		if (Spec->HasReachedMaxFailures())
+		{
+			Spec->AddWarning(FString::Printf(TEXT("Fail-fast: skipping remaining tests after %i failures"), FAutomatronSettings::Get().MaxFailures), 0);
+			Spec->OnFailFast();
+			// Following runs start from scratch
+			Spec->CurrentContext = {};
+		}
+	}
+
+	// Failures often end early or time out, their durations are not comparable
+	if (Result.bPassed)
+	{
+		FSpecRunHistory::Get().Record(Spec->TestName + TEXT(" ") + SpecToRun->Id, Result.GetDuration());
+	}
+
+	FSpecResultCache& Cache = FSpecResultCache::Get();
+	if (Cache.IsEnabled() && !InputsHash.IsEmpty())
+	{
+		if (Result.bPassed)
+		{
+			Cache.MarkPassed(Spec->TestName, SpecToRun->Id, InputsHash);
+		}
+		else
+		{
+			Cache.MarkFailed(Spec->TestName, SpecToRun->Id);
+		}
+	}
+
+	if (bReport)
+	{
+		Report.TestName = Spec->TestName;
+		Report.SpecId = SpecToRun->Id;
+		Report.Description = SpecToRun->Description;
+		Report.Filename = SpecToRun->Filename;
+		Report.LineNumber = SpecToRun->LineNumber;
+		Report.Duration = Result.GetDuration();
+		Report.Attempts = Attempts;
+		Report.bPassed = Result.bPassed;
+		Report.bPassedOnRetry = Result.PassedOnRetry();
+		Report.bQuarantined = Result.bQuarantined;
+		FSpecResultReporter::Get().Add(Report);
+	}
+
+	LastResult = MoveTemp(Result);
+	Reset();
+}
+
+
+bool FTestSpecBase::FStressLatentCommand::Update()
+{
+	// Don't block the game thread for too long when runs are quick
+	static constexpr double FrameBudget = 0.1;
+	const double StartedUpdate = FPlatformTime::Seconds();
+
+	while (true)
+	{
+		if (OrderIndex >= Order.Num())
+		{
+			if (!ShouldStartRun())
+			{
+				Report();
+				return true;
+			}
+
+			if (RunIndex != INDEX_NONE && FPlatformTime::Seconds() - StartedUpdate > FrameBudget)
+			{
+				// Start the next run on the next frame
+				return false;
+			}
+			StartRun();
+		}
+
+		FRunSpecLatentCommand& Runner = *Runners[Order[OrderIndex]];
+		if (!Runner.Update())
+		{
+			return false;
+		}
+
+		FinishSpec(Runner);
+		if (++OrderIndex >= Order.Num())
+		{
+			FinishRun();
+		}
+	}
+}
+
+bool FTestSpecBase::FStressLatentCommand::ShouldStartRun() const
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	const int32 NextRun = RunIndex + 1;
+	if (NextRun == 0)
+	{
+		return Runners.Num() > 0;
+	}
+
+	if (Settings.StressRuns > 0 && NextRun >= Settings.StressRuns)
+	{
+		return false;
+	}
+	if (Settings.StressSeconds > 0.0 && FPlatformTime::Seconds() - StartedStressing >= Settings.StressSeconds)
+	{
+		return false;
+	}
+	return true;
+}
+
+void FTestSpecBase::FStressLatentCommand::StartRun()
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+
+	++RunIndex;
+	if (RunIndex == 0)
+	{
+		StartedStressing = FPlatformTime::Seconds();
+		FirstEntry = Spec->ExecutionInfo.GetEntries().Num();
+	}
+
+	Order.Reset(Runners.Num());
+	for (int32 Index = 0; Index < Runners.Num(); ++Index)
+	{
+		Order.Add(Index);
+	}
+
+	if (Settings.bStressShuffle)
+	{
+		FRandomStream Stream(Settings.StressSeed + RunIndex);
+		for (int32 Index = Order.Num() - 1; Index > 0; --Index)
+		{
+			Order.Swap(Index, Stream.RandRange(0, Index));
+		}
+	}
+
+	OrderIndex = 0;
+	bRunFailed = false;
+	StartedRun = FPlatformTime::Seconds();
+
+	// Every run starts as a fresh execution of the stressed specs
+	Spec->CurrentContext = {};
+	Spec->NumTestsInRun = Runners.Num();
+}
+
+void FTestSpecBase::FStressLatentCommand::FinishSpec(const FRunSpecLatentCommand& Runner)
+{
+	// Errors are only accounted for. Leaving them would make the next runs skip.
+	// Those reported before the first run (e.g: duplicate ids) stay
+	const TArray<FString> Errors = Spec->ExtractErrorsSince(FirstEntry);
+	if (Errors.Num() == 0)
+	{
+		return;
+	}
+
+	if (FirstFailedRun == INDEX_NONE)
+	{
+		FirstFailedRun = RunIndex;
+		FirstFailedSeed = FAutomatronSettings::Get().StressSeed + RunIndex;
+		FirstFailedSpec = Runner.GetSpec().Id;
+		FirstFailedLog = Errors;
+	}
+	bRunFailed = true;
+}
+
+void FTestSpecBase::FStressLatentCommand::FinishRun()
+{
+	RunDurations.Add(FPlatformTime::Seconds() - StartedRun);
+	if (bRunFailed)
+	{
+		++FailedRuns;
+	}
+}
+
+void FTestSpecBase::FStressLatentCommand::Report()
+{
+	RunDurations.Sort();
+
+	const int32 NumRuns = RunDurations.Num();
+	double TotalDuration = 0.0;
+	for (double Duration : RunDurations)
+	{
+		TotalDuration += Duration;
+	}
+
+	const FString Summary = FString::Printf(TEXT("Stress: %i runs, %i failed (%.2f%%). Run time (ms) min %.3f, avg %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f"),
+		NumRuns, FailedRuns, NumRuns > 0 ? 100.0 * FailedRuns / NumRuns : 0.0,
+		GetPercentile(RunDurations, 0.0) * 1000.0,
+		NumRuns > 0 ? TotalDuration / NumRuns * 1000.0 : 0.0,
+		GetPercentile(RunDurations, 0.5) * 1000.0,
+		GetPercentile(RunDurations, 0.95) * 1000.0,
+		GetPercentile(RunDurations, 0.99) * 1000.0,
+		GetPercentile(RunDurations, 1.0) * 1000.0);
+
+	UE_LOG(LogAutomatron, Display, TEXT("%s"), *Summary);
+	Spec->AddInfo(Summary);
+
+	// Benchmarks are tracked across runs like tests
+	FSpecRunHistory::Get().Record(Spec->TestName + TEXT(" [Stress p50]"), GetPercentile(RunDurations, 0.5));
+	FSpecRunHistory::Get().Record(Spec->TestName + TEXT(" [Stress p95]"), GetPercentile(RunDurations, 0.95));
+
+	if (FirstFailedRun != INDEX_NONE)
+	{
+		// The seed only matters if it shuffled the order
+		const FString Seed = FAutomatronSettings::Get().bStressShuffle? FString::Printf(TEXT(" (seed %i)"), FirstFailedSeed) : FString();
+		Spec->AddError(FString::Printf(TEXT("Stress: first failure on run %i%s in '%s':"), FirstFailedRun, *Seed, *FirstFailedSpec), 0);
+		for (const FString& Line : FirstFailedLog)
+		{
+			Spec->AddError(FString::Printf(TEXT("  %s"), *Line), 0);
+		}
+	}
+}
+
+
+bool FTestSpecBase::RunTest(const FString& InParameters)
+{
+	EnsureDefinitions();
+
+	for (const FString& Id : DuplicateIds)
+	{
+		if (InParameters.IsEmpty() || InParameters == Id)
+		{
+			AddError(FString::Printf(TEXT("Test '%s' is defined more than once. Only the first definition runs"), *Id), 0);
+		}
+	}
+
+	TArray<TSharedRef<FSpec>> SpecsToRun;
+	if (!InParameters.IsEmpty())
+	{
+		const TSharedRef<FSpec>* SpecToRun = IdToSpecMap.Find(InParameters);
+		if (SpecToRun != nullptr)
+		{
+			SpecsToRun.Add(*SpecToRun);
+		}
+	}
+	else
+	{
+		IdToSpecMap.GenerateValueArray(SpecsToRun);
+		SpecsToRun.RemoveAll([this](const TSharedRef<FSpec>& Spec)
+		{
+			return !IsSelected(*Spec);
+		});
+	}
+
+	if (HasReachedMaxFailures())
+	{
+		AddWarning(TEXT("Skipped by fail-fast"), 0);
+		for (const TSharedRef<FSpec>& Spec : SpecsToRun)
+		{
+			ReportSkipped(*Spec, TEXT("Skipped by fail-fast"));
+		}
+		return true;
+	}
+
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	if (Settings.IsStressEnabled())
+	{
+		TArray<TSharedRef<FRunSpecLatentCommand>> StressRunners;
+		for (const TSharedRef<FSpec>& Spec : SpecsToRun)
+		{
+			if (Settings.IsStressed(Spec->Id))
+			{
+				StressRunners.Add(MakeShared<FRunSpecLatentCommand>(this, Spec));
+			}
+		}
+
+		if (StressRunners.Num() > 0)
+		{
+			NumTestsInRun = StressRunners.Num();
+			FAutomationTestFramework::GetInstance().EnqueueLatentCommand(MakeShared<FStressLatentCommand>(this, MoveTemp(StressRunners)));
+			TestsRemaining = GetNumTests();
+			return true;
+		}
+	}
+
+	FString InputsHash;
+	FSpecResultCache& Cache = FSpecResultCache::Get();
+	if (Cache.IsEnabled() && CanCacheResults())
+	{
+		InputsHash = Cache.HashInputs(ModuleName, CacheInputs);
+	}
+
+	// Set when the first test of a run starts. Tests of a run can be started one by one, so
+	// the run covers every selected test. Filtered out and cached tests never start
+	if (!CurrentContext)
+	{
+		TArray<TSharedRef<FSpec>> SpecsInRun;
+		IdToSpecMap.GenerateValueArray(SpecsInRun);
+		NumTestsInRun = GetNumTestsToRun(SpecsInRun, InputsHash);
+
+		// Starting tests that all pass from the cache leaves no context, but skipped tests are reported once per run
+		if (FSpecResultReporter::Get().MarkSkippedReported(TestName))
+		{
+			for (const TSharedRef<FSpec>& Spec : SpecsInRun)
+			{
+				if (!IsSelected(*Spec))
+				{
+					ReportSkipped(*Spec, FSpecTagQuery::Get().Matches(Spec->TagBits)? TEXT("Not affected by the change") : TEXT("Excluded by tag query"));
+				}
+			}
+		}
+	}
+
+	for (const TSharedRef<FSpec>& Spec : SpecsToRun)
+	{
+		if (Cache.HasPassed(TestName, Spec->Id, InputsHash))
+		{
+			AddInfo(FString::Printf(TEXT("Cached pass: '%s' didn't change since it last passed"), *Spec->Id));
+
+			FSpecReport Report;
+			Report.TestName = TestName;
+			Report.SpecId = Spec->Id;
+			Report.Description = Spec->Description;
+			Report.Filename = Spec->Filename;
+			Report.LineNumber = Spec->LineNumber;
+			Report.bPassed = true;
+			Report.bCached = true;
+			FSpecResultReporter::Get().Add(Report);
+			continue;
+		}
+		FAutomationTestFramework::GetInstance().EnqueueLatentCommand(MakeShared<FRunSpecLatentCommand>(this, Spec, InputsHash));
+	}
+
+	TestsRemaining = GetNumTests();
+	return true;
+}
+
+bool FTestSpecBase::IsStressTest() const
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	if (!Settings.IsStressEnabled())
+	{
+		return false;
+	}
+
+	EnsureDefinitions();
+	for (const auto& Entry : IdToSpecMap)
+	{
+		if (Settings.IsStressed(Entry.Key))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FTestSpecBase::AddError(const FString& InError, int32 StackOffset)
+{
+	if (!IsInGameThread())
+	{
+		PendingErrors.Increment();
+		PendingEvents.Enqueue(FAutomationEvent(EAutomationEventType::Error, InError));
+		return;
+	}
+
+	// Keep the order of events from other threads
+	MergePendingEvents();
+	FAutomationTestBase::AddError(InError, StackOffset + 1);
+	bHadErrorsOnLastMerge = true;
+}
+
+void FTestSpecBase::AddWarning(const FString& InWarning, int32 StackOffset)
+{
+	if (!IsInGameThread())
+	{
+		PendingEvents.Enqueue(FAutomationEvent(EAutomationEventType::Warning, InWarning));
+		return;
+	}
+
+	MergePendingEvents();
+	FAutomationTestBase::AddWarning(InWarning, StackOffset + 1);
+}
+
+void FTestSpecBase::AddInfo(const FString& InLogItem, int32 StackOffset)
+{
+	if (!IsInGameThread())
+	{
+		PendingEvents.Enqueue(FAutomationEvent(EAutomationEventType::Info, InLogItem));
+		return;
+	}
+
+	MergePendingEvents();
+	FAutomationTestBase::AddInfo(InLogItem, StackOffset + 1);
+}
+
+bool FTestSpecBase::CompareSnapshot(const FString& Name, TArrayView<const uint8> Data, bool bAsText)
+{
+	FSpecSnapshot Snapshot{ GetTestSourceFileName(), TestName, Name };
+	const FSpecSnapshot::EFormat Format = bAsText? FSpecSnapshot::EFormat::Text : FSpecSnapshot::EFormat::Binary;
+	switch (Snapshot.Compare(Data, Format, FAutomatronSettings::Get().bUpdateSnapshots))
+	{
+	case FSpecSnapshot::EResult::Matched:
+		return true;
+	case FSpecSnapshot::EResult::Created:
+		AddWarning(FString::Printf(TEXT("Snapshot '%s' didn't exist. Created at '%s'"), *Name, *Snapshot.GetPath()), 1);
+		return true;
+	case FSpecSnapshot::EResult::Updated:
+		AddInfo(FString::Printf(TEXT("Snapshot '%s' updated"), *Name));
+		return true;
+	default:
+		AddError(Snapshot.GetReport(), 1);
+		return false;
+	}
+}
+
+void FTestSpecBase::AddTimeoutError()
+{
+	AddError(TEXT("Latent command timed out."), 0);
+
+	const FString Callstacks = FSpecHangWatchdog::Get().EndWatch();
+	if (!Callstacks.IsEmpty())
+	{
+		TArray<FString> Lines;
+		Callstacks.ParseIntoArrayLines(Lines);
+		for (const FString& Line : Lines)
+		{
+			AddInfo(Line);
+		}
+	}
+}
+
+uint32 FTestSpecBase::BeginHangWatch(const FTimespan& Timeout)
+{
+	return FSpecHangWatchdog::Get().BeginWatch(Timeout);
+}
+
+void FTestSpecBase::EndHangWatch()
+{
+	FSpecHangWatchdog::Get().EndWatch();
+}
+
+void FTestSpecBase::WatchCurrentThread(uint32 WatchId)
+{
+	FSpecHangWatchdog::Get().SetWorkerThread(WatchId, FPlatformTLS::GetCurrentThreadId());
+}
+
+void FTestSpecBase::WakeUp()
+{
+	GetWakeUpEvent()->Trigger();
+}
+
+void FTestSpecBase::SleepWhileWaiting() const
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The editor keeps drawing and taking input on the game thread while tests run. Unless nobody is watching
+	// or it can't draw, it keeps ticking frames, only fewer of them. This also keeps worlds ticking
+	static double LastFrameEndTime = 0.;
+	uint32 SleepMs = 0;
+	if (GIsEditor && !FApp::IsUnattended() && FApp::CanEverRender())
+	{
+		if (Settings.IdleFrameRate > 0)
+		{
+			const double FrameSeconds = 1. / Settings.IdleFrameRate;
+			const double ElapsedSeconds = StartTime - LastFrameEndTime;
+			SleepMs = ElapsedSeconds < FrameSeconds ? FMath::FloorToInt((FrameSeconds - ElapsedSeconds) * 1000.) : 0;
+		}
+	}
+	else if (CanSleepWhileWaiting())
+	{
+		SleepMs = FMath::Max(Settings.IdleSleepMs, 0);
+	}
+
+	if (SleepMs > 0)
+	{
+		GetWakeUpEvent()->Wait(SleepMs);
+		LastFrameEndTime = FPlatformTime::Seconds();
+		FAutomatronRunStats::Get().SleptSeconds += LastFrameEndTime - StartTime;
+	}
+	else
+	{
+		LastFrameEndTime = StartTime;
+	}
+}
+
+bool FTestSpecBase::HasAnyErrorsThreadSafe() const
+{
+	if (PendingErrors.GetValue() > 0)
+	{
+		return true;
+	}
+	return IsInGameThread() ? HasAnyErrors() : (bool)bHadErrorsOnLastMerge;
+}
+
+void FTestSpecBase::MergePendingEvents()
+{
+	check(IsInGameThread());
+
+	FAutomationEvent Event(EAutomationEventType::Info, FString());
+	while (PendingEvents.Dequeue(Event))
+	{
+		if (Event.Type == EAutomationEventType::Error)
+		{
+			FAutomationTestBase::AddError(Event.Message, 0);
+			PendingErrors.Decrement();
+		}
+		else if (Event.Type == EAutomationEventType::Warning)
+		{
+			FAutomationTestBase::AddWarning(Event.Message, 0);
+		}
+		else
+		{
+			FAutomationTestBase::AddInfo(Event.Message, 0);
+		}
+	}
+	bHadErrorsOnLastMerge = HasAnyErrors();
+}
+
+bool FTestSpecBase::IsFailingFast() const
+{
+	return bFailureReachesMaxFailures && HasAnyErrorsThreadSafe();
+}
+
+bool FTestSpecBase::IsQuarantined(const FString& SpecId) const
+{
+	return FAutomatronSettings::Get().IsQuarantined(SpecId);
+}
+
+bool FTestSpecBase::HasReachedMaxFailures(int32 PendingFailures) const
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	if (!Settings.IsFailFastEnabled())
+	{
+		return false;
+	}
+
+	const FAutomatronRunStats& Stats = FAutomatronRunStats::Get();
+	if (Settings.bFailFastWholeRun)
+	{
+		return Stats.Failures + PendingFailures >= Settings.MaxFailures;
+	}
+
+	const int32* SpecFailures = Stats.FailuresBySpec.Find(TestName);
+	return (SpecFailures? *SpecFailures : 0) + PendingFailures >= Settings.MaxFailures;
+}
+
+FString FTestSpecBase::GetTestSourceFileName(const FString& InTestName) const
+{
+	FString TestId = InTestName;
+	if (TestId.StartsWith(TestName + TEXT(" ")))
+	{
+		TestId = InTestName.RightChop(TestName.Len() + 1);
+	}
+
+	const TSharedRef<FSpec>* Spec = IdToSpecMap.Find(TestId);
+	if (Spec != nullptr)
+	{
+		return (*Spec)->Filename;
+	}
+
+	return GetTestSourceFileName();
+}
+
+int32 FTestSpecBase::GetTestSourceFileLine(const FString& InTestName) const
+{
+	FString TestId = InTestName;
+	if (TestId.StartsWith(TestName + TEXT(" ")))
+	{
+		TestId = InTestName.RightChop(TestName.Len() + 1);
+	}
+
+	const TSharedRef<FSpec>* Spec = IdToSpecMap.Find(TestId);
+	if (Spec != nullptr)
+	{
+		return (*Spec)->LineNumber;
+	}
+
+	return GetTestSourceFileLine();
+}
+
+void FTestSpecBase::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	EnsureDefinitions();
+
+	TArray<TSharedRef<FSpec>> Specs;
+	IdToSpecMap.GenerateValueArray(Specs);
+
+	FSpecImpactMap& ImpactMap = FSpecImpactMap::Get();
+	const bool bRecordImpact = ImpactMap.IsRecording();
+
+	for (int32 Index = 0; Index < Specs.Num(); Index++)
+	{
+		if (bRecordImpact)
+		{
+			ImpactMap.Record(TestName, Specs[Index]->Id, { Specs[Index]->Filename, GetTestSourceFileName() });
+		}
+
+		if (!IsSelected(*Specs[Index]))
+		{
+			continue;
+		}
+
+		OutTestCommands.Push(Specs[Index]->Id);
+		OutBeautifiedNames.Push(Specs[Index]->Description);
+	}
+}
+
+void FTestSpecBase::ReportSkipped(const FSpec& Spec, const FString& Reason) const
+{
+	FSpecReport Report;
+	Report.TestName = TestName;
+	Report.SpecId = Spec.Id;
+	Report.Description = Spec.Description;
+	Report.Filename = Spec.Filename;
+	Report.LineNumber = Spec.LineNumber;
+	Report.bSkipped = true;
+	Report.SkipReason = Reason;
+	FSpecResultReporter::Get().Add(Report);
+}
+
+bool FTestSpecBase::MatchesTags(const FString& SpecId, const FSpecTagQuery& Query) const
+{
+	EnsureDefinitions();
+	const TSharedRef<FSpec>* Spec = IdToSpecMap.Find(SpecId);
+	return Spec && Query.Matches((*Spec)->TagBits);
+}
+
+bool FTestSpecBase::IsSelected(const FSpec& Spec) const
+{
+	return FSpecTagQuery::Get().Matches(Spec.TagBits) && FSpecImpactMap::Get().IsAffected(TestName, Spec.Id);
+}
+
+int32 FTestSpecBase::GetNumTestsToRun(const TArray<TSharedRef<FSpec>>& Specs, const FString& InputsHash) const
+{
+	const FSpecResultCache& Cache = FSpecResultCache::Get();
+
+	int32 NumToRun = 0;
+	for (const TSharedRef<FSpec>& Spec : Specs)
+	{
+		NumToRun += IsSelected(*Spec) && !Cache.HasPassed(TestName, Spec->Id, InputsHash);
+	}
+	return NumToRun;
+}
+
+void FTestSpecBase::Describe(const FString& InDescription, TFunction<void()> DoWork)
+{
+	Describe(InDescription, FSpecTags(), MoveTemp(DoWork));
+}
+
+void FTestSpecBase::Describe(const FString& InDescription, const FSpecTags& InTags, TFunction<void()> DoWork)
+{
+	const TSharedRef<FSpecDefinitionScope> ParentScope = DefinitionScopeStack.Last();
+	const TSharedRef<FSpecDefinitionScope> NewScope = MakeShared<FSpecDefinitionScope>();
+	NewScope->Description = InDescription;
+	NewScope->Tags = InTags;
+	ParentScope->Children.Push(NewScope);
+
+	DefinitionScopeStack.Push(NewScope);
+	PushDescription(InDescription);
+	DoWork();
+	PopDescription(InDescription);
+	DefinitionScopeStack.Pop();
+
+	if (NewScope->It.Num() == 0 && NewScope->Children.Num() == 0)
+	{
+		ParentScope->Children.Remove(NewScope);
+	}
+}
+
+void FTestSpecBase::PreDefine()
+{
+	BeforeEach([this]()
+	{
+		CurrentContext = CurrentContext.NextContext();
+	});
+}
+void FTestSpecBase::PostDefine()
+{
+	AfterEach([this]()
+	{
+		if (IsLastTest())
+		{
+			CurrentContext = {};
+
+			// The running test keeps its baked commands alive, so definitions can go now
+			if (bRedefinePending)
+			{
+				Redefine();
+			}
+		}
+	});
+}
+
+void FTestSpecBase::DefineAndBake()
+{
+	FSpecBakeEntry Entry;
+	Entry.TestName = TestName;
+
+	const double StartTime = FPlatformTime::Seconds();
+	RunDefine();
+	const double DefinedTime = FPlatformTime::Seconds();
+	BakeDefinitions(Entry);
+
+	Entry.DefineSeconds = DefinedTime - StartTime;
+	Entry.BakeSeconds = FPlatformTime::Seconds() - DefinedTime;
+	FSpecBakeReport::Get().Record(MoveTemp(Entry));
+}
+
+void FTestSpecBase::BakeDefinitions(FSpecBakeEntry& OutEntry)
+{
+	TArray<TSharedRef<FSpecDefinitionScope>> Stack;
+	Stack.Push(RootDefinitionScope.ToSharedRef());
+
+	TArray<TSharedRef<IAutomationLatentCommand>> BeforeEach;
+	TArray<TSharedRef<IAutomationLatentCommand>> AfterEach;
+
+	// Children inherit the tags of their parents. Kept aside, so that baking again doesn't inherit them twice
+	TMap<const FSpecDefinitionScope*, TArray<FString>> ScopeTags;
+	ScopeTags.Add(RootDefinitionScope.Get(), RootDefinitionScope->Tags.Names);
+	TArray<TSharedRef<FSpecDefinitionScope>> TaggedScopes = Stack;
+	for (int32 Index = 0; Index < TaggedScopes.Num(); ++Index)
+	{
+		for (const TSharedRef<FSpecDefinitionScope>& Child : TaggedScopes[Index]->Children)
+		{
+			TArray<FString> Tags = ScopeTags.FindChecked(&TaggedScopes[Index].Get());
+			Tags.Append(Child->Tags.Names);
+			ScopeTags.Add(&Child.Get(), MoveTemp(Tags));
+			TaggedScopes.Add(Child);
+		}
+	}
+
+	FSpecTagIndex& TagIndex = FSpecTagIndex::Get();
+
+	while (Stack.Num() > 0)
+	{
+		const TSharedRef<FSpecDefinitionScope> Scope = Stack.Last();
+
+		BeforeEach.Append(Scope->BeforeEach);
+		// ScopeAfter each are added reversed
+		AfterEach.Reserve(AfterEach.Num() + Scope->AfterEach.Num());
+		for(int32 i = Scope->AfterEach.Num() - 1; i >= 0; --i)
+		{
+			AfterEach.Add(Scope->AfterEach[i]);
+		}
+
+		for (int32 ItIndex = 0; ItIndex < Scope->It.Num(); ItIndex++)
+		{
+			TSharedRef<FSpecIt> It = Scope->It[ItIndex];
+
+			if (IdToSpecMap.Contains(It->Id))
+			{
+				DuplicateIds.AddUnique(It->Id);
+				OutEntry.DuplicateIds.AddUnique(It->Id);
+				continue;
+			}
+
+			TSharedRef<FSpec> Spec = MakeShared<FSpec>();
+			Spec->Id = It->Id;
+			Spec->Description = It->Description;
+			Spec->Filename = It->Filename;
+			Spec->LineNumber = It->LineNumber;
+			Spec->Options = It->Options;
+			TArray<FString> SpecTags = ScopeTags.FindChecked(&Scope.Get());
+			SpecTags.Append(It->Options.Tags.Names);
+			Spec->TagBits = TagIndex.MakeBits(SpecTags);
+			Spec->Commands.Append(BeforeEach);
+			Spec->Commands.Add(It->Command);
+
+			// Add after each reversed
+			for (int32 i = AfterEach.Num() - 1; i >= 0; --i)
+			{
+				Spec->Commands.Add(AfterEach[i]);
+			}
+
+			if (bFuseAsyncCommands)
+			{
+				FuseAsyncCommands(Spec->Commands);
+			}
+
+			++OutEntry.NumTests;
+			OutEntry.MaxBeforeEach = FMath::Max(OutEntry.MaxBeforeEach, BeforeEach.Num());
+			OutEntry.TotalBeforeEach += BeforeEach.Num();
+			OutEntry.MaxAfterEach = FMath::Max(OutEntry.MaxAfterEach, AfterEach.Num());
+			OutEntry.TotalAfterEach += AfterEach.Num();
+			OutEntry.NumCommands += Spec->Commands.Num();
+			for (const TSharedRef<IAutomationLatentCommand>& Command : Spec->Commands)
+			{
+				OutEntry.EstimatedFrames += !ImmediateCommands.Contains(&Command.Get());
+			}
+
+			IdToSpecMap.Add(Spec->Id, Spec);
+		}
+		Scope->It.Empty();
+
+		if (Scope->Children.Num() > 0)
+		{
+			Stack.Append(Scope->Children);
+			Scope->Children.Empty();
+		}
+		else
+		{
+			while (Stack.Num() > 0 && Stack.Last()->Children.Num() == 0 && Stack.Last()->It.Num() == 0)
+			{
+				const TSharedRef<FSpecDefinitionScope> PoppedScope = Stack.Pop();
+
+				if (PoppedScope->BeforeEach.Num() > 0)
+				{
+					BeforeEach.RemoveAt(BeforeEach.Num() - PoppedScope->BeforeEach.Num(), PoppedScope->BeforeEach.Num());
+				}
+
+				if (PoppedScope->AfterEach.Num() > 0)
+				{
+					AfterEach.RemoveAt(AfterEach.Num() - PoppedScope->AfterEach.Num(), PoppedScope->AfterEach.Num());
+				}
+			}
+		}
+	}
+
+	RootDefinitionScope.Reset();
+	DefinitionScopeStack.Reset();
+	bHasBeenDefined = true;
+}
+
+void FTestSpecBase::FuseAsyncCommands(TArray<TSharedRef<IAutomationLatentCommand>>& Commands)
+{
+	TArray<TSharedRef<IAutomationLatentCommand>> FusedCommands;
+	FusedCommands.Reserve(Commands.Num());
+
+	TArray<TSharedRef<FAsyncLatentCommand>> Steps;
+	auto FlushSteps = [this, &FusedCommands, &Steps]()
+	{
+		if (Steps.Num() == 1)
+		{
+			FusedCommands.Add(Steps[0]);
+		}
+		else if (Steps.Num() > 1)
+		{
+			FusedCommands.Add(MakeShared<FFusedAsyncLatentCommand>(this, MoveTemp(Steps)));
+		}
+		Steps.Reset();
+	};
+
+	for (const TSharedRef<IAutomationLatentCommand>& Command : Commands)
+	{
+		if (!FusableCommands.Contains(&Command.Get()))
+		{
+			FlushSteps();
+			FusedCommands.Add(Command);
+			continue;
+		}
+
+		const TSharedRef<FAsyncLatentCommand> AsyncCommand = StaticCastSharedRef<FAsyncLatentCommand>(Command);
+		if (Steps.Num() > 0 && Steps[0]->Execution != AsyncCommand->Execution)
+		{
+			FlushSteps();
+		}
+		Steps.Add(AsyncCommand);
+	}
+	FlushSteps();
+
+	Commands = MoveTemp(FusedCommands);
+}
+
+void FTestSpecBase::Redefine()
+{
+	Description.Empty();
+	IdToSpecMap.Empty();
+	FusableCommands.Empty();
+	ImmediateCommands.Empty();
+	DuplicateIds.Empty();
+	RootDefinitionScope = MakeShared<FSpecDefinitionScope>();
+	DefinitionScopeStack.Reset();
+	DefinitionScopeStack.Push(RootDefinitionScope.ToSharedRef());
+	bHasBeenDefined = false;
+	bRedefinePending = false;
+}
+
+void FTestSpecBase::RequestRedefine()
+{
+	if (!bHasBeenDefined)
+	{
+		return;
+	}
+
+	// Tests of this spec are running and hold on to the current definitions
+	if (CurrentContext)
+	{
+		bRedefinePending = true;
+		return;
+	}
+	Redefine();
+}
+
+void FTestSpecBase::RedefineModule(const FString& InModuleName)
+{
+	int32 NumRedefined = 0;
+	int32 NumStale = 0;
+	TSet<FString> Names;
+	TArray<FTestSpecBase*>& AllSpecs = GetAllSpecs();
+
+	// Newest first. Instances of a spec constructed earlier belong to the previous binary, whose code is stale
+	for (int32 Index = AllSpecs.Num() - 1; Index >= 0; --Index)
+	{
+		FTestSpecBase* Spec = AllSpecs[Index];
+		if (Spec->ModuleName != InModuleName)
+		{
+			continue;
+		}
+
+		bool bAlreadySeen = false;
+		Names.Add(Spec->TestName, &bAlreadySeen);
+		if (bAlreadySeen)
+		{
+			AllSpecs.RemoveAt(Index);
+			++NumStale;
+		}
+		else if (Spec->bHasBeenDefined)
+		{
+			Spec->RequestRedefine();
+			++NumRedefined;
+		}
+	}
+
+	if (NumRedefined > 0 || NumStale > 0)
+	{
+		UE_LOG(LogAutomatron, Log, TEXT("Module '%s' reloaded. Redefining %i specs, skipping %i of the previous binary"), *InModuleName, NumRedefined, NumStale);
+	}
+}
+
+void FTestSpecBase::RedefineAll()
+{
+	for (FTestSpecBase* Spec : GetAllSpecs())
+	{
+		Spec->RequestRedefine();
+	}
+}
+
+TArray<FTestSpecBase*>& FTestSpecBase::GetAllSpecs()
+{
+	static TArray<FTestSpecBase*> AllSpecs;
+	return AllSpecs;
+}
+
+TArray<FString> FTestSpecBase::ExtractErrorsSince(int32 FirstEntry)
+{
+	TArray<FString> Extracted;
+
+	// Removed in place, so the remaining entries keep their order and the ones before FirstEntry their index.
+	// Entries are visited in order, which is how their index is tracked
+	int32 Index = 0;
+	ExecutionInfo.RemoveAllEvents([&Extracted, &Index, FirstEntry](FAutomationEvent& Event)
+	{
+		const bool bExtract = Index++ >= FirstEntry && Event.Type == EAutomationEventType::Error;
+		if (bExtract)
+		{
+			Extracted.Add(Event.Message);
+		}
+		return bExtract;
+	});
+	return Extracted;
+}
+
+FString FTestSpecBase::GetDescription() const
+{
+	FString CompleteDescription;
+	for (int32 Index = 0; Index < Description.Num(); ++Index)
+	{
+		if (Description[Index].IsEmpty())
+		{
+			continue;
+		}
+
+		if (CompleteDescription.IsEmpty())
+		{
+			CompleteDescription = Description[Index];
+		}
+		else if (FChar::IsWhitespace(CompleteDescription[CompleteDescription.Len() - 1]) || FChar::IsWhitespace(Description[Index][0]))
+		{
+			CompleteDescription = CompleteDescription + TEXT(".") + Description[Index];
+		}
+		else
+		{
+			CompleteDescription = FString::Printf(TEXT("%s.%s"), *CompleteDescription, *Description[Index]);
+		}
+	}
+
+	return CompleteDescription;
+}
+
+FString FTestSpecBase::GetId() const
+{
+	if (Description.Last().EndsWith(TEXT("]")))
+	{
+		FString ItDescription = Description.Last();
+		ItDescription.RemoveAt(ItDescription.Len() - 1);
+
+		int32 StartingBraceIndex = INDEX_NONE;
+		if (ItDescription.FindLastChar(TEXT('['), StartingBraceIndex) && StartingBraceIndex != ItDescription.Len() - 1)
+		{
+			FString CommandId = ItDescription.RightChop(StartingBraceIndex + 1);
+			return CommandId;
+		}
+	}
+
+	FString CompleteId;
+	for (int32 Index = 0; Index < Description.Num(); ++Index)
+	{
+		if (Description[Index].IsEmpty())
+		{
+			continue;
+		}
+
+		if (CompleteId.IsEmpty())
+		{
+			CompleteId = Description[Index];
+		}
+		else if (FChar::IsWhitespace(CompleteId[CompleteId.Len() - 1]) || FChar::IsWhitespace(Description[Index][0]))
+		{
+			CompleteId = CompleteId + Description[Index];
+		}
+		else
+		{
+			CompleteId = FString::Printf(TEXT("%s %s"), *CompleteId, *Description[Index]);
+		}
+	}
+
+	return CompleteId;
+}
@@ -0,0 +1,105 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/BakeReport.h"
+#include <Misc/FileHelper.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+FSpecBakeReport& FSpecBakeReport::Get()
+{
+	static FSpecBakeReport Report;
+	return Report;
+}
+
+bool FSpecBakeReport::IsEnabled() const
+{
+	return !FAutomatronSettings::Get().BakeReportFile.IsEmpty();
+}
+
+void FSpecBakeReport::Record(FSpecBakeEntry&& Entry)
+{
+	UE_LOG(LogAutomatron, Verbose, TEXT("Baked '%s': %i tests, %i commands, ~%i frames. Defined in %.2fms, baked in %.2fms"),
+		*Entry.TestName, Entry.NumTests, Entry.NumCommands, Entry.EstimatedFrames, Entry.DefineSeconds * 1000.0, Entry.BakeSeconds * 1000.0);
+
+	for (const FString& Id : Entry.DuplicateIds)
+	{
+		UE_LOG(LogAutomatron, Error, TEXT("'%s' defines the test '%s' more than once. Only the first one will run"), *Entry.TestName, *Id);
+	}
+
+	if (IsEnabled())
+	{
+		const FString TestName = Entry.TestName;
+		Entries.Add(TestName, MoveTemp(Entry));
+	}
+}
+
+void FSpecBakeReport::Save() const
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	TArray<const FSpecBakeEntry*> Sorted;
+	for (const auto& Entry : Entries)
+	{
+		Sorted.Add(&Entry.Value);
+	}
+	// Most expensive first
+	Sorted.Sort([](const FSpecBakeEntry& A, const FSpecBakeEntry& B)
+	{
+		return A.EstimatedFrames > B.EstimatedFrames;
+	});
+
+	int32 TotalTests = 0;
+	int32 TotalCommands = 0;
+	int32 TotalFrames = 0;
+	double TotalSeconds = 0.0;
+	for (const FSpecBakeEntry* Entry : Sorted)
+	{
+		TotalTests += Entry->NumTests;
+		TotalCommands += Entry->NumCommands;
+		TotalFrames += Entry->EstimatedFrames;
+		TotalSeconds += Entry->DefineSeconds + Entry->BakeSeconds;
+	}
+
+	FString Report = TEXT("# Automatron bake report") LINE_TERMINATOR LINE_TERMINATOR;
+	Report += FString::Printf(TEXT("%i specs with %i tests enqueue %i commands and take at least %i frames. Defining and baking took %.2fms.") LINE_TERMINATOR LINE_TERMINATOR,
+		Sorted.Num(), TotalTests, TotalCommands, TotalFrames, TotalSeconds * 1000.0);
+
+	Report += TEXT("| Spec | Tests | BeforeEach (max / avg) | AfterEach (max / avg) | Commands | Est. frames | Define (ms) | Bake (ms) |") LINE_TERMINATOR;
+	Report += TEXT("|---|---:|---:|---:|---:|---:|---:|---:|") LINE_TERMINATOR;
+	for (const FSpecBakeEntry* Entry : Sorted)
+	{
+		const double Tests = FMath::Max(1, Entry->NumTests);
+		Report += FString::Printf(TEXT("| %s | %i | %i / %.1f | %i / %.1f | %i | %i | %.2f | %.2f |") LINE_TERMINATOR,
+			*Entry->TestName.Replace(TEXT("|"), TEXT("\\|")), Entry->NumTests,
+			Entry->MaxBeforeEach, Entry->TotalBeforeEach / Tests,
+			Entry->MaxAfterEach, Entry->TotalAfterEach / Tests,
+			Entry->NumCommands, Entry->EstimatedFrames, Entry->DefineSeconds * 1000.0, Entry->BakeSeconds * 1000.0);
+	}
+
+	FString Duplicates;
+	for (const FSpecBakeEntry* Entry : Sorted)
+	{
+		for (const FString& Id : Entry->DuplicateIds)
+		{
+			Duplicates += FString::Printf(TEXT("- %s: `%s`") LINE_TERMINATOR, *Entry->TestName, *Id);
+		}
+	}
+	if (!Duplicates.IsEmpty())
+	{
+		Report += LINE_TERMINATOR TEXT("## Duplicate test ids") LINE_TERMINATOR LINE_TERMINATOR;
+		Report += Duplicates;
+	}
+
+	const FString& Path = FAutomatronSettings::Get().BakeReportFile;
+	if (!FFileHelper::SaveStringToFile(Report, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogAutomatron, Warning, TEXT("Failed to save bake report to '%s'"), *Path);
+		return;
+	}
+	UE_LOG(LogAutomatron, Display, TEXT("Bake report of %i specs saved to '%s'"), Sorted.Num(), *Path);
+}
@@ -0,0 +1,49 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Shape and definition cost of a baked spec class
+struct FSpecBakeEntry
+{
+	FString TestName;
+	int32 NumTests = 0;
+
+	int32 MaxBeforeEach = 0;
+	int32 TotalBeforeEach = 0;
+	int32 MaxAfterEach = 0;
+	int32 TotalAfterEach = 0;
+
+	// Commands enqueued by all tests, after fusing
+	int32 NumCommands = 0;
+
+	// Frames all tests take at least. Every command that isn't synchronous waits for one
+	int32 EstimatedFrames = 0;
+
+	double DefineSeconds = 0.0;
+	double BakeSeconds = 0.0;
+
+	TArray<FString> DuplicateIds;
+};
+
+
+// Bake entries of every spec class, saved as markdown with -Automatron.BakeReport=<file>.
+// Long BeforeEach and AfterEach chains are paid once per test, so they are reported next to the test count.
+class FSpecBakeReport
+{
+	// By test name. Redefined specs replace their entry
+	TMap<FString, FSpecBakeEntry> Entries;
+
+
+public:
+
+	static FSpecBakeReport& Get();
+
+	bool IsEnabled() const;
+
+	void Record(FSpecBakeEntry&& Entry);
+
+	void Save() const;
+};
@@ -0,0 +1,138 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/HangWatchdog.h"
+#include <HAL/PlatformStackWalk.h>
+#include <HAL/RunnableThread.h>
+#include <HAL/ThreadManager.h>
+#include <Misc/ScopeLock.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+FSpecHangWatchdog::~FSpecHangWatchdog()
+{
+	Shutdown();
+}
+
+FSpecHangWatchdog& FSpecHangWatchdog::Get()
+{
+	static FSpecHangWatchdog Watchdog;
+	return Watchdog;
+}
+
+uint32 FSpecHangWatchdog::BeginWatch(const FTimespan& Timeout)
+{
+	const float Fraction = FAutomatronSettings::Get().HangDumpFraction;
+	if (Fraction <= 0.f || !FPlatformProcess::SupportsMultithreading())
+	{
+		return 0;
+	}
+
+	if (!Thread)
+	{
+		StartThread();
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	bWatching = true;
+	WatchDeadline = FPlatformTime::Seconds() + Timeout.GetTotalSeconds() * Fraction;
+	WorkerThreadId = 0;
+	Report.Empty();
+
+	// Zero is never a valid id
+	WatchId = FMath::Max(WatchId + 1, 1u);
+	return WatchId;
+}
+
+void FSpecHangWatchdog::SetWorkerThread(uint32 InWatchId, uint32 ThreadId)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (bWatching && InWatchId == WatchId)
+	{
+		WorkerThreadId = ThreadId;
+	}
+}
+
+FString FSpecHangWatchdog::EndWatch()
+{
+	FScopeLock ScopeLock(&Lock);
+	bWatching = false;
+	WorkerThreadId = 0;
+	return MoveTemp(Report);
+}
+
+void FSpecHangWatchdog::Shutdown()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeUp)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUp);
+		WakeUp = nullptr;
+	}
+}
+
+uint32 FSpecHangWatchdog::Run()
+{
+	while (!bStopping)
+	{
+		WakeUp->Wait(100);
+
+		uint32 WorkerToDump = 0;
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (!bWatching || !Report.IsEmpty() || FPlatformTime::Seconds() < WatchDeadline)
+			{
+				continue;
+			}
+			WorkerToDump = WorkerThreadId;
+		}
+
+		// Walking stacks is slow, don't hold the lock meanwhile
+		FString Dump = TEXT("Game thread callstack:\n") + DumpThread(GGameThreadId);
+		if (WorkerToDump != 0)
+		{
+			Dump += FString::Printf(TEXT("\nWorker thread '%s' callstack:\n"), *FThreadManager::GetThreadName(WorkerToDump));
+			Dump += DumpThread(WorkerToDump);
+		}
+		UE_LOG(LogAutomatron, Warning, TEXT("Latent command is close to timing out.\n%s"), *Dump);
+
+		FScopeLock ScopeLock(&Lock);
+		if (bWatching)
+		{
+			Report = MoveTemp(Dump);
+		}
+	}
+	return 0;
+}
+
+void FSpecHangWatchdog::Stop()
+{
+	bStopping = true;
+	if (WakeUp)
+	{
+		WakeUp->Trigger();
+	}
+}
+
+void FSpecHangWatchdog::StartThread()
+{
+	bStopping = false;
+	WakeUp = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("AutomatronHangWatchdog"), 0, TPri_BelowNormal);
+}
+
+FString FSpecHangWatchdog::DumpThread(uint32 ThreadId)
+{
+	static constexpr SIZE_T StackSize = 16 * 1024;
+	ANSICHAR Stack[StackSize];
+	Stack[0] = 0;
+	FPlatformStackWalk::ThreadStackWalkAndDump(Stack, StackSize, 0, ThreadId);
+	return ANSI_TO_TCHAR(Stack);
+}
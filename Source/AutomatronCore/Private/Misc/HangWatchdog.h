@@ -0,0 +1,54 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <HAL/Runnable.h>
+#include <HAL/ThreadSafeBool.h>
+
+
+// Watches the latent command being run. When it exceeds a fraction of its timeout, the callstacks of
+// the game thread and of the worker running its async body are captured, so that a timeout can tell where it hung.
+class FSpecHangWatchdog : public FRunnable
+{
+	FCriticalSection Lock;
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeUp = nullptr;
+	FThreadSafeBool bStopping;
+
+	// Watched command. Guarded by Lock
+	bool bWatching = false;
+	double WatchDeadline = 0.0;
+	uint32 WorkerThreadId = 0;
+	FString Report;
+
+	// Increased on every watch, so that bodies abandoned by a previous one can't set its worker
+	uint32 WatchId = 0;
+
+
+public:
+
+	~FSpecHangWatchdog();
+
+	static FSpecHangWatchdog& Get();
+
+	// Returns the id of the watch, to pass to SetWorkerThread from the worker
+	uint32 BeginWatch(const FTimespan& Timeout);
+	void SetWorkerThread(uint32 InWatchId, uint32 ThreadId);
+
+	// Stops watching, returning the callstacks captured if the command took too long
+	FString EndWatch();
+
+	void Shutdown();
+
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+private:
+
+	void StartThread();
+
+	static FString DumpThread(uint32 ThreadId);
+};
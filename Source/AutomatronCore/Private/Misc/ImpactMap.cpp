@@ -0,0 +1,367 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/ImpactMap.h"
+#include <Dom/JsonObject.h>
+#include <HAL/FileManager.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonSerializer.h>
+#include <Serialization/JsonWriter.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+FSpecImpactMap& FSpecImpactMap::Get()
+{
+	static FSpecImpactMap ImpactMap = []()
+	{
+		FSpecImpactMap NewMap;
+		NewMap.Initialize();
+		return NewMap;
+	}();
+	return ImpactMap;
+}
+
+bool FSpecImpactMap::IsRecording() const
+{
+	return !FAutomatronSettings::Get().RecordImpactMapFile.IsEmpty();
+}
+
+void FSpecImpactMap::Record(const FString& TestName, const FString& SpecId, const TArray<FString>& SourceFiles)
+{
+	FSpecEntry& Entry = Specs.FindOrAdd(MakeKey(TestName, SpecId));
+	for (const FString& File : SourceFiles)
+	{
+		if (File.IsEmpty())
+		{
+			continue;
+		}
+
+		const FString RelativeFile = MakeProjectRelative(File);
+		Entry.Files.AddUnique(RelativeFile);
+		if (Entry.Module.IsEmpty())
+		{
+			Entry.Module = FindModule(RelativeFile);
+		}
+	}
+}
+
+void FSpecImpactMap::Save() const
+{
+	const FString& Path = FAutomatronSettings::Get().RecordImpactMapFile;
+	if (Path.IsEmpty())
+	{
+		return;
+	}
+
+	TSharedRef<FJsonObject> ModulesObject = MakeShared<FJsonObject>();
+	for (const auto& Module : Modules)
+	{
+		TSharedRef<FJsonObject> ModuleObject = MakeShared<FJsonObject>();
+		ModuleObject->SetStringField(TEXT("Directory"), Module.Value.Directory);
+
+		TArray<TSharedPtr<FJsonValue>> Dependencies;
+		for (const FString& Dependency : Module.Value.Dependencies)
+		{
+			Dependencies.Add(MakeShared<FJsonValueString>(Dependency));
+		}
+		ModuleObject->SetArrayField(TEXT("Dependencies"), Dependencies);
+		ModulesObject->SetObjectField(Module.Key, ModuleObject);
+	}
+
+	TSharedRef<FJsonObject> SpecsObject = MakeShared<FJsonObject>();
+	for (const auto& Spec : Specs)
+	{
+		TSharedRef<FJsonObject> SpecObject = MakeShared<FJsonObject>();
+		SpecObject->SetStringField(TEXT("Module"), Spec.Value.Module);
+
+		TArray<TSharedPtr<FJsonValue>> Files;
+		for (const FString& File : Spec.Value.Files)
+		{
+			Files.Add(MakeShared<FJsonValueString>(File));
+		}
+		SpecObject->SetArrayField(TEXT("Files"), Files);
+		SpecsObject->SetObjectField(Spec.Key, SpecObject);
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetObjectField(TEXT("Modules"), ModulesObject);
+	Root->SetObjectField(TEXT("Specs"), SpecsObject);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogAutomatron, Display, TEXT("Saved impact map of %i specs to '%s'"), Specs.Num(), *Path);
+	}
+	else
+	{
+		UE_LOG(LogAutomatron, Error, TEXT("Failed to save impact map to '%s'"), *Path);
+	}
+}
+
+bool FSpecImpactMap::IsAffected(const FString& TestName, const FString& SpecId) const
+{
+	if (!bSelecting || bAllAffected)
+	{
+		return true;
+	}
+
+	const FSpecEntry* Entry = Specs.Find(MakeKey(TestName, SpecId));
+	if (!Entry)
+	{
+		// New specs didn't exist when the map was recorded
+		return true;
+	}
+
+	if (AffectedModules.Contains(Entry->Module))
+	{
+		return true;
+	}
+
+	for (const FString& ChangedFile : ChangedFiles)
+	{
+		for (const FString& File : Entry->Files)
+		{
+			if (MatchesChangedFile(ChangedFile, File))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void FSpecImpactMap::Initialize()
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	if (IsRecording())
+	{
+		ScanModules();
+	}
+
+	if (!Settings.ImpactMapFile.IsEmpty() && !Settings.ChangedFilesFile.IsEmpty())
+	{
+		Select(Settings.ImpactMapFile, Settings.ChangedFilesFile);
+	}
+}
+
+bool FSpecImpactMap::Select(const FString& MapPath, const FString& ChangedFilesPath)
+{
+	if (!Load(MapPath))
+	{
+		UE_LOG(LogAutomatron, Warning, TEXT("Couldn't load impact map '%s'. All specs will run"), *MapPath);
+		return false;
+	}
+	LoadChangedFiles(ChangedFilesPath);
+	bSelecting = true;
+	return true;
+}
+
+void FSpecImpactMap::ScanModules()
+{
+	TArray<FString> BuildFiles;
+	IFileManager::Get().FindFilesRecursive(BuildFiles, *FPaths::ProjectDir(), TEXT("*.Build.cs"), true, false);
+
+	for (const FString& BuildFile : BuildFiles)
+	{
+		const FString Name = FPaths::GetCleanFilename(BuildFile).LeftChop(FString(TEXT(".Build.cs")).Len());
+
+		FModuleInfo& Module = Modules.FindOrAdd(Name);
+		Module.Directory = MakeProjectRelative(FPaths::GetPath(BuildFile));
+
+		FString Contents;
+		if (!FFileHelper::LoadFileToString(Contents, *BuildFile))
+		{
+			continue;
+		}
+
+		// Collect every quoted name inside "...DependencyModuleNames..." statements
+		int32 Start = Contents.Find(TEXT("DependencyModuleNames"));
+		while (Start != INDEX_NONE)
+		{
+			const int32 End = Contents.Find(TEXT(";"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Start);
+			if (End == INDEX_NONE)
+			{
+				break;
+			}
+
+			TArray<FString> Tokens;
+			Contents.Mid(Start, End - Start).ParseIntoArray(Tokens, TEXT("\""), false);
+			// Quoted strings are the odd tokens
+			for (int32 Index = 1; Index < Tokens.Num(); Index += 2)
+			{
+				Module.Dependencies.AddUnique(Tokens[Index]);
+			}
+			Start = Contents.Find(TEXT("DependencyModuleNames"), ESearchCase::CaseSensitive, ESearchDir::FromStart, End);
+		}
+	}
+}
+
+bool FSpecImpactMap::Load(const FString& Path)
+{
+	FString Json;
+	if (!FFileHelper::LoadFileToString(Json, *Path))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+	{
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* ModulesObject;
+	if (Root->TryGetObjectField(TEXT("Modules"), ModulesObject))
+	{
+		for (const auto& ModuleField : (*ModulesObject)->Values)
+		{
+			const TSharedPtr<FJsonObject> ModuleObject = ModuleField.Value->AsObject();
+			if (!ModuleObject.IsValid())
+			{
+				continue;
+			}
+
+			FModuleInfo& Module = Modules.FindOrAdd(ModuleField.Key);
+			Module.Directory = ModuleObject->GetStringField(TEXT("Directory"));
+			ModuleObject->TryGetStringArrayField(TEXT("Dependencies"), Module.Dependencies);
+		}
+	}
+
+	const TSharedPtr<FJsonObject>* SpecsObject;
+	if (Root->TryGetObjectField(TEXT("Specs"), SpecsObject))
+	{
+		for (const auto& SpecField : (*SpecsObject)->Values)
+		{
+			const TSharedPtr<FJsonObject> SpecObject = SpecField.Value->AsObject();
+			if (!SpecObject.IsValid())
+			{
+				continue;
+			}
+
+			FSpecEntry& Entry = Specs.FindOrAdd(SpecField.Key);
+			Entry.Module = SpecObject->GetStringField(TEXT("Module"));
+			SpecObject->TryGetStringArrayField(TEXT("Files"), Entry.Files);
+		}
+	}
+	return true;
+}
+
+void FSpecImpactMap::LoadChangedFiles(const FString& Path)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+	{
+		UE_LOG(LogAutomatron, Warning, TEXT("Couldn't load changed files '%s'. All specs will run"), *Path);
+		bAllAffected = true;
+		return;
+	}
+
+	TSet<FString> ChangedModules;
+	for (FString& Line : Lines)
+	{
+		Line.TrimStartAndEndInline();
+		if (Line.IsEmpty())
+		{
+			continue;
+		}
+		FPaths::NormalizeFilename(Line);
+
+		// Build rules change how everything compiles
+		if (Line.EndsWith(TEXT(".Build.cs")) || Line.EndsWith(TEXT(".Target.cs")) ||
+			Line.EndsWith(TEXT(".uplugin")) || Line.EndsWith(TEXT(".uproject")))
+		{
+			bAllAffected = true;
+		}
+
+		const FString Module = FindModule(Line);
+		if (!Module.IsEmpty())
+		{
+			ChangedModules.Add(Module);
+		}
+		ChangedFiles.Add(MoveTemp(Line));
+	}
+
+	// Any module depending, even indirectly, on a changed one is affected
+	AffectedModules = ChangedModules;
+	bool bAddedAny = true;
+	while (bAddedAny)
+	{
+		bAddedAny = false;
+		for (const auto& Module : Modules)
+		{
+			if (AffectedModules.Contains(Module.Key))
+			{
+				continue;
+			}
+
+			for (const FString& Dependency : Module.Value.Dependencies)
+			{
+				if (AffectedModules.Contains(Dependency))
+				{
+					AffectedModules.Add(Module.Key);
+					bAddedAny = true;
+					break;
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogAutomatron, Display, TEXT("Impact analysis: %i changed files affect %i modules"), ChangedFiles.Num(), AffectedModules.Num());
+}
+
+FString FSpecImpactMap::FindModule(const FString& RelativeFile) const
+{
+	// The deepest module directory containing the file owns it
+	FString BestModule;
+	int32 BestLength = 0;
+	for (const auto& Module : Modules)
+	{
+		const FString& Directory = Module.Value.Directory;
+		if (Directory.Len() > BestLength && MatchesChangedFile(RelativeFile, Directory + TEXT("/")))
+		{
+			BestModule = Module.Key;
+			BestLength = Directory.Len();
+		}
+	}
+	return BestModule;
+}
+
+FString FSpecImpactMap::MakeProjectRelative(const FString& File)
+{
+	FString RelativeFile = FPaths::ConvertRelativePathToFull(File);
+	FPaths::MakePathRelativeTo(RelativeFile, *FPaths::ConvertRelativePathToFull(FPaths::ProjectDir()));
+	FPaths::NormalizeFilename(RelativeFile);
+	return RelativeFile;
+}
+
+bool FSpecImpactMap::MatchesChangedFile(const FString& ChangedFile, const FString& RelativeFile)
+{
+	// Changed files can be relative to the repository root instead of the project,
+	// so RelativeFile may only match a trailing part of the path.
+	// A RelativeFile ending in '/' matches anything inside that directory.
+	FString Pattern = RelativeFile;
+	while (Pattern.StartsWith(TEXT("../")))
+	{
+		Pattern = Pattern.RightChop(3);
+	}
+
+	const bool bIsDirectory = Pattern.EndsWith(TEXT("/"));
+	int32 Found = ChangedFile.Find(Pattern, ESearchCase::IgnoreCase);
+	while (Found != INDEX_NONE)
+	{
+		const bool bStartsAtSegment = Found == 0 || ChangedFile[Found - 1] == TEXT('/');
+		const bool bEndsAtFile = bIsDirectory || Found + Pattern.Len() == ChangedFile.Len();
+		if (bStartsAtSegment && bEndsAtFile)
+		{
+			return true;
+		}
+		Found = ChangedFile.Find(Pattern, ESearchCase::IgnoreCase, ESearchDir::FromStart, Found + 1);
+	}
+	return false;
+}
@@ -0,0 +1,100 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/LogCapture.h"
+#include <Algo/Reverse.h>
+
+#include "AutomatronSettings.h"
+
+
+FSpecLogCapture::FSpecLogCapture(int32 InCapacity)
+	: Capacity(FMath::Max(1, InCapacity))
+{}
+
+FSpecLogCapture& FSpecLogCapture::Get()
+{
+	static FSpecLogCapture Capture{ FAutomatronSettings::Get().LogCaptureCapacity };
+	return Capture;
+}
+
+int32 FSpecLogCapture::BeginTest()
+{
+	check(IsInGameThread());
+	if (Slots.Num() == 0)
+	{
+		// Writers only touch the slots once a tag is active
+		Slots.SetNum(Capacity);
+	}
+	ActiveTag = ++LastTag;
+	return LastTag;
+}
+
+void FSpecLogCapture::EndTest()
+{
+	ActiveTag = 0;
+}
+
+TArray<FString> FSpecLogCapture::GetLines(int32 Tag, ELogVerbosity::Type MaxVerbosity, int32 MaxLines) const
+{
+	TArray<FString> Lines;
+	if (MaxLines <= 0 || Slots.Num() == 0)
+	{
+		return Lines;
+	}
+
+	// Walk backwards from the newest line so that only the last MaxLines are copied
+	const uint64 End = WriteIndex.Load();
+	const uint64 Start = End > (uint64)Capacity ? End - Capacity : 0;
+
+	TCHAR Text[MaxLineLength];
+	for (uint64 Index = End; Index > Start && Lines.Num() < MaxLines; --Index)
+	{
+		const FSlot& Slot = Slots[(Index - 1) % Capacity];
+		if (Slot.Sequence.Load() != Index || Slot.Tag != Tag || Slot.Verbosity > MaxVerbosity)
+		{
+			continue;
+		}
+
+		const FName Category = Slot.Category;
+		FCString::Strncpy(Text, Slot.Text, MaxLineLength);
+
+		// Discard the line if it got overwritten while copying
+		if (Slot.Sequence.Load() == Index)
+		{
+			Lines.Add(FString::Printf(TEXT("%s: %s"), *Category.ToString(), Text));
+		}
+	}
+
+	Algo::Reverse(Lines);
+	return Lines;
+}
+
+void FSpecLogCapture::Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category)
+{
+	// Ordered with the allocation of the slots in BeginTest
+	const int32 Tag = ActiveTag.Load();
+	if (Tag == 0)
+	{
+		return;
+	}
+
+	const uint64 Index = WriteIndex++;
+	FSlot& Slot = Slots[Index % Capacity];
+
+	// Writers that lapped the buffer can land on the same slot. Only one owns it at a time: the line is
+	// dropped if another writer is still on the slot or a newer line already claimed it
+	uint64 Sequence = Slot.Sequence.Load();
+	do
+	{
+		if ((Sequence & WritingFlag) != 0 || Sequence > Index)
+		{
+			return;
+		}
+	}
+	while (!Slot.Sequence.CompareExchange(Sequence, WritingFlag | (Index + 1)));
+
+	Slot.Tag = Tag;
+	Slot.Verbosity = ELogVerbosity::Type(Verbosity & ELogVerbosity::VerbosityMask);
+	Slot.Category = Category;
+	FCString::Strncpy(Slot.Text, V, MaxLineLength);
+	Slot.Sequence = Index + 1;
+}
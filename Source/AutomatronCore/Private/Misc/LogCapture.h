@@ -0,0 +1,56 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Misc/OutputDevice.h>
+#include <Templates/Atomic.h>
+
+
+// Captures log lines emitted while a test runs into a fixed-size lock-free ring buffer.
+// Lines are tagged with the active test, so that only its own lines are attached if it fails.
+// The buffer is allocated when the first test is captured, so runs that don't use it don't pay for it.
+class FSpecLogCapture : public FOutputDevice
+{
+	static constexpr int32 MaxLineLength = 256;
+
+	struct FSlot
+	{
+		// Index + 1 of the line in the slot, with WritingFlag while a writer owns it
+		TAtomic<uint64> Sequence { 0 };
+		int32 Tag = 0;
+		ELogVerbosity::Type Verbosity = ELogVerbosity::Log;
+		FName Category;
+		TCHAR Text[MaxLineLength];
+	};
+
+	static constexpr uint64 WritingFlag = 1ull << 63;
+
+	// Allocated by the first BeginTest, before any line is captured
+	TArray<FSlot> Slots;
+	const int32 Capacity;
+	TAtomic<uint64> WriteIndex { 0 };
+
+	// Tag of the active test. Zero when no test is running
+	TAtomic<int32> ActiveTag { 0 };
+	int32 LastTag = 0;
+
+
+public:
+
+	FSpecLogCapture(int32 InCapacity);
+
+	static FSpecLogCapture& Get();
+
+	// Starts tagging lines with a new test. Game thread only
+	int32 BeginTest();
+	void EndTest();
+
+	// Returns the last MaxLines lines of a test at or above a verbosity. Older lines may have been overwritten
+	TArray<FString> GetLines(int32 Tag, ELogVerbosity::Type MaxVerbosity, int32 MaxLines) const;
+
+	//~ Begin FOutputDevice Interface
+	virtual void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override;
+	virtual bool CanBeUsedOnAnyThread() const override { return true; }
+	//~ End FOutputDevice Interface
+};
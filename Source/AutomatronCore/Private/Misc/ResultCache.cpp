@@ -0,0 +1,163 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/ResultCache.h"
+#include <HAL/PlatformProcess.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <Misc/SecureHash.h>
+#include <Modules/ModuleManager.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+FSpecResultCache& FSpecResultCache::Get()
+{
+	static FSpecResultCache Cache = []()
+	{
+		FSpecResultCache NewCache;
+		if (NewCache.IsEnabled())
+		{
+			NewCache.Load();
+		}
+		return NewCache;
+	}();
+	return Cache;
+}
+
+bool FSpecResultCache::IsEnabled() const
+{
+	return FAutomatronSettings::Get().bResultCache;
+}
+
+FString FSpecResultCache::HashInputs(const FString& ModuleName, const TArray<FString>& DataInputs) const
+{
+	if (ModuleName.IsEmpty())
+	{
+		return {};
+	}
+
+#if IS_MONOLITHIC
+	const FString Binary = FPlatformProcess::ExecutablePath();
+#else
+	const FString Binary = FModuleManager::Get().GetModuleFilename(*ModuleName);
+#endif
+	const FString& BinaryHash = HashFile(Binary);
+	if (BinaryHash.IsEmpty())
+	{
+		return {};
+	}
+
+	FMD5 Hash;
+	auto AddToHash = [&Hash](const FString& Value)
+	{
+		const FTCHARToUTF8 Converted(*Value);
+		Hash.Update(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+	};
+
+	AddToHash(BinaryHash);
+	for (const FString& Input : DataInputs)
+	{
+		const FString& InputHash = HashFile(Input);
+		if (InputHash.IsEmpty())
+		{
+			// Missing inputs are part of the state too
+			AddToHash(TEXT("Missing:") + Input);
+		}
+		else
+		{
+			AddToHash(InputHash);
+		}
+	}
+
+	uint8 Digest[16];
+	Hash.Final(Digest);
+	return BytesToHex(Digest, 16);
+}
+
+bool FSpecResultCache::HasPassed(const FString& TestName, const FString& SpecId, const FString& InputsHash) const
+{
+	if (InputsHash.IsEmpty() || FAutomatronSettings::Get().bForceRun)
+	{
+		return false;
+	}
+
+	const FString* PassedHash = PassedHashes.Find(MakeKey(TestName, SpecId));
+	return PassedHash && *PassedHash == InputsHash;
+}
+
+void FSpecResultCache::MarkPassed(const FString& TestName, const FString& SpecId, const FString& InputsHash)
+{
+	if (!InputsHash.IsEmpty())
+	{
+		PassedHashes.Add(MakeKey(TestName, SpecId), InputsHash);
+		bDirty = true;
+	}
+}
+
+void FSpecResultCache::MarkFailed(const FString& TestName, const FString& SpecId)
+{
+	bDirty |= PassedHashes.Remove(MakeKey(TestName, SpecId)) > 0;
+}
+
+void FSpecResultCache::Save()
+{
+	if (!bDirty)
+	{
+		return;
+	}
+
+	// One "<hash> <test name> <spec id>" entry per line
+	FString Contents;
+	for (const auto& Entry : PassedHashes)
+	{
+		Contents += FString::Printf(TEXT("%s %s\n"), *Entry.Value, *Entry.Key);
+	}
+
+	const FString& Path = FAutomatronSettings::Get().ResultCacheFile;
+	if (FFileHelper::SaveStringToFile(Contents, *Path))
+	{
+		bDirty = false;
+	}
+	else
+	{
+		UE_LOG(LogAutomatron, Warning, TEXT("Failed to save result cache to '%s'"), *Path);
+	}
+
+	// Binaries and inputs may change before the next run
+	FileHashes.Reset();
+}
+
+void FSpecResultCache::Load()
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FAutomatronSettings::Get().ResultCacheFile))
+	{
+		return;
+	}
+
+	for (const FString& Line : Lines)
+	{
+		FString Hash, Key;
+		if (Line.Split(TEXT(" "), &Hash, &Key) && !Key.IsEmpty())
+		{
+			PassedHashes.Add(MoveTemp(Key), MoveTemp(Hash));
+		}
+	}
+}
+
+const FString& FSpecResultCache::HashFile(const FString& Path) const
+{
+	if (const FString* CachedHash = FileHashes.Find(Path))
+	{
+		return *CachedHash;
+	}
+
+	FString Hash;
+	const FMD5Hash FileHash = FMD5Hash::HashFile(*Path);
+	if (FileHash.IsValid())
+	{
+		Hash = LexToString(FileHash);
+	}
+	return FileHashes.Add(Path, MoveTemp(Hash));
+}
@@ -0,0 +1,43 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Remembers specs that passed, keyed by the content of what they depend on.
+// A spec whose module binary and data inputs didn't change since it passed doesn't need to run again.
+class FSpecResultCache
+{
+	// Spec key to the hash of its inputs when it last passed
+	TMap<FString, FString> PassedHashes;
+
+	// Hashes of module binaries and input files. Computed once per run
+	mutable TMap<FString, FString> FileHashes;
+
+	bool bDirty = false;
+
+
+public:
+
+	static FSpecResultCache& Get();
+
+	bool IsEnabled() const;
+
+	// Returns an empty string if the inputs of the spec can't be hashed
+	FString HashInputs(const FString& ModuleName, const TArray<FString>& DataInputs) const;
+
+	bool HasPassed(const FString& TestName, const FString& SpecId, const FString& InputsHash) const;
+	void MarkPassed(const FString& TestName, const FString& SpecId, const FString& InputsHash);
+	void MarkFailed(const FString& TestName, const FString& SpecId);
+
+	void Save();
+
+private:
+
+	void Load();
+
+	const FString& HashFile(const FString& Path) const;
+
+	static FString MakeKey(const FString& TestName, const FString& SpecId) { return TestName + TEXT(" ") + SpecId; }
+};
@@ -0,0 +1,223 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/ResultReporter.h"
+#include <HAL/FileManager.h>
+#include <Policies/CondensedJsonPrintPolicy.h>
+#include <Serialization/JsonWriter.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+namespace
+{
+	const TCHAR* JUnitHeader = TEXT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n<testsuite name=\"Automatron\">\n");
+	const TCHAR* JUnitFooter = TEXT("</testsuite>\n</testsuites>\n");
+}
+
+
+FSpecResultReporter& FSpecResultReporter::Get()
+{
+	static FSpecResultReporter Reporter;
+	return Reporter;
+}
+
+bool FSpecResultReporter::IsEnabled() const
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	return !Settings.JUnitReportFile.IsEmpty() || !Settings.JsonReportFile.IsEmpty();
+}
+
+void FSpecResultReporter::Begin()
+{
+	SkippedReported.Reset();
+	Open();
+}
+
+void FSpecResultReporter::Open()
+{
+	End();
+	bEnded = false;
+
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+	if (!Settings.JUnitReportFile.IsEmpty())
+	{
+		JUnit = IFileManager::Get().CreateFileWriter(*Settings.JUnitReportFile);
+		if (JUnit)
+		{
+			Write(*JUnit, JUnitHeader);
+			JUnitFooterOffset = JUnit->Tell();
+			Write(*JUnit, JUnitFooter);
+			JUnit->Flush();
+		}
+		else
+		{
+			UE_LOG(LogAutomatron, Warning, TEXT("Failed to open JUnit report '%s'"), *Settings.JUnitReportFile);
+		}
+	}
+
+	if (!Settings.JsonReportFile.IsEmpty())
+	{
+		Json = IFileManager::Get().CreateFileWriter(*Settings.JsonReportFile);
+		if (!Json)
+		{
+			UE_LOG(LogAutomatron, Warning, TEXT("Failed to open JSON report '%s'"), *Settings.JsonReportFile);
+		}
+	}
+}
+
+void FSpecResultReporter::Add(const FSpecReport& Report)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	// Tests can run without the framework broadcasting the start of the run
+	if (!JUnit && !Json && !bEnded)
+	{
+		Open();
+	}
+
+	if (JUnit)
+	{
+		WriteJUnit(Report);
+	}
+	if (Json)
+	{
+		WriteJson(Report);
+	}
+}
+
+bool FSpecResultReporter::MarkSkippedReported(const FString& TestName)
+{
+	bool bAlreadyReported = false;
+	SkippedReported.Add(TestName, &bAlreadyReported);
+	return !bAlreadyReported;
+}
+
+void FSpecResultReporter::End()
+{
+	bEnded = true;
+	if (JUnit)
+	{
+		JUnit->Close();
+		delete JUnit;
+		JUnit = nullptr;
+	}
+	if (Json)
+	{
+		Json->Close();
+		delete Json;
+		Json = nullptr;
+	}
+}
+
+void FSpecResultReporter::WriteJUnit(const FSpecReport& Report)
+{
+	FString Case = FString::Printf(TEXT("<testcase classname=\"%s\" name=\"%s\" file=\"%s\" line=\"%i\" time=\"%.3f\">\n"),
+		*EscapeXml(Report.TestName), *EscapeXml(Report.SpecId), *EscapeXml(Report.Filename), Report.LineNumber, Report.Duration);
+
+	if (Report.bCached)
+	{
+		Case += TEXT("<skipped message=\"Cached pass\"/>\n");
+	}
+	else if (Report.bSkipped)
+	{
+		Case += FString::Printf(TEXT("<skipped message=\"%s\"/>\n"), *EscapeXml(Report.SkipReason));
+	}
+	else if (Report.bPassedOnRetry)
+	{
+		// Flaky test convention of Surefire, understood by most CI servers
+		Case += FString::Printf(TEXT("<flakyFailure message=\"Passed on attempt %i\"/>\n"), Report.Attempts);
+	}
+	else if (!Report.bPassed)
+	{
+		const FString Message = Report.Errors.Num() > 0? Report.Errors[0] : FString{ TEXT("Failed") };
+		const FString Details = FString::Join(Report.Errors, TEXT("\n"));
+		if (Report.bQuarantined)
+		{
+			Case += FString::Printf(TEXT("<skipped message=\"Quarantined: %s\"/>\n"), *EscapeXml(Message));
+		}
+		else
+		{
+			Case += FString::Printf(TEXT("<failure message=\"%s\">%s</failure>\n"), *EscapeXml(Message), *EscapeXml(Details));
+		}
+	}
+
+	if (Report.Warnings.Num() > 0)
+	{
+		Case += FString::Printf(TEXT("<system-out>%s</system-out>\n"), *EscapeXml(FString::Join(Report.Warnings, TEXT("\n"))));
+	}
+	Case += TEXT("</testcase>\n");
+
+	JUnit->Seek(JUnitFooterOffset);
+	Write(*JUnit, Case);
+	JUnitFooterOffset = JUnit->Tell();
+	Write(*JUnit, JUnitFooter);
+	JUnit->Flush();
+}
+
+void FSpecResultReporter::WriteJson(const FSpecReport& Report)
+{
+	const TCHAR* Status = Report.bCached? TEXT("cached")
+		: Report.bSkipped? TEXT("skipped")
+		: Report.bPassedOnRetry? TEXT("passed_on_retry")
+		: Report.bPassed? TEXT("passed")
+		: Report.bQuarantined? TEXT("quarantined")
+		: TEXT("failed");
+
+	FString Line;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Line);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("test"), Report.TestName);
+	Writer->WriteValue(TEXT("id"), Report.SpecId);
+	Writer->WriteValue(TEXT("description"), Report.Description);
+	Writer->WriteValue(TEXT("file"), Report.Filename);
+	Writer->WriteValue(TEXT("line"), Report.LineNumber);
+	Writer->WriteValue(TEXT("status"), Status);
+	Writer->WriteValue(TEXT("duration"), Report.Duration);
+	Writer->WriteValue(TEXT("attempts"), Report.Attempts);
+	if (Report.bSkipped)
+	{
+		Writer->WriteValue(TEXT("skip_reason"), Report.SkipReason);
+	}
+	Writer->WriteValue(TEXT("errors"), Report.Errors);
+	Writer->WriteValue(TEXT("warnings"), Report.Warnings);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	Write(*Json, Line + TEXT("\n"));
+	Json->Flush();
+}
+
+void FSpecResultReporter::Write(FArchive& Archive, const FString& Text)
+{
+	const FTCHARToUTF8 Utf8Text(*Text);
+	Archive.Serialize((void*)Utf8Text.Get(), Utf8Text.Length());
+}
+
+FString FSpecResultReporter::EscapeXml(const FString& Text)
+{
+	FString Escaped;
+	Escaped.Reserve(Text.Len());
+	for (TCHAR Char : Text)
+	{
+		switch (Char)
+		{
+		case TEXT('&'):  Escaped += TEXT("&amp;"); break;
+		case TEXT('<'):  Escaped += TEXT("&lt;"); break;
+		case TEXT('>'):  Escaped += TEXT("&gt;"); break;
+		case TEXT('"'):  Escaped += TEXT("&quot;"); break;
+		case TEXT('\''): Escaped += TEXT("&apos;"); break;
+		default:
+			// Control characters are not valid XML 1.0
+			if (Char >= 0x20 || Char == TEXT('\n') || Char == TEXT('\t'))
+			{
+				Escaped.AppendChar(Char);
+			}
+			break;
+		}
+	}
+	return Escaped;
+}
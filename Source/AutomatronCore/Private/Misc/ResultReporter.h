@@ -0,0 +1,81 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+class FArchive;
+
+
+// Outcome of a spec, as written to reports
+struct FSpecReport
+{
+	FString TestName;
+	FString SpecId;
+	FString Description;
+	FString Filename;
+	int32 LineNumber = 0;
+
+	// Seconds, including all attempts
+	double Duration = 0.0;
+	int32 Attempts = 0;
+
+	bool bPassed = false;
+	// Passed after failing at least one attempt. See FSpecItOptions::Retries
+	bool bPassedOnRetry = false;
+	bool bQuarantined = false;
+	// Passed on a previous run and didn't run again. See FSpecResultCache
+	bool bCached = false;
+	// Didn't run, e.g: fail-fast or not affected by the change. See SkipReason
+	bool bSkipped = false;
+	FString SkipReason;
+
+	TArray<FString> Errors;
+	TArray<FString> Warnings;
+};
+
+
+// Writes JUnit XML and JSON-lines reports as specs finish.
+// Files are flushed after every spec so that a crash keeps every result reported until then.
+// The JUnit footer is rewritten after each test case, keeping the XML valid at all times.
+class FSpecResultReporter
+{
+	FArchive* JUnit = nullptr;
+
+	// Where the closing tags start. Next test case overwrites them
+	int64 JUnitFooterOffset = 0;
+
+	FArchive* Json = nullptr;
+
+	// Results added after the end of the run are dropped instead of truncating the reports
+	bool bEnded = false;
+
+	// Specs whose skipped tests were reported this run
+	TSet<FString> SkippedReported;
+
+
+public:
+
+	~FSpecResultReporter() { End(); }
+
+	static FSpecResultReporter& Get();
+
+	bool IsEnabled() const;
+
+	void Begin();
+	void Add(const FSpecReport& Report);
+	void End();
+
+	// True only the first time per run, so that a spec started many times in a run reports its skipped tests once
+	bool MarkSkippedReported(const FString& TestName);
+
+private:
+
+	void Open();
+
+	void WriteJUnit(const FSpecReport& Report);
+	void WriteJson(const FSpecReport& Report);
+
+	static void Write(FArchive& Archive, const FString& Text);
+	static FString EscapeXml(const FString& Text);
+};
@@ -0,0 +1,221 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/RunHistory.h"
+#include <HAL/FileManager.h>
+#include <HAL/IConsoleManager.h>
+#include <Misc/Guid.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+namespace
+{
+	// Makes the median absolute deviation comparable to a standard deviation
+	constexpr double MADScale = 1.4826;
+
+	FAutoConsoleCommand RegressionReportCommand(
+		TEXT("Automatron.RegressionReport"),
+		TEXT("Compares the last run in the Automatron history with the previous ones"),
+		FConsoleCommandDelegate::CreateLambda([]() { FSpecRunHistory::WriteReport(); }));
+}
+
+
+FSpecRunHistory& FSpecRunHistory::Get()
+{
+	static FSpecRunHistory History;
+	return History;
+}
+
+bool FSpecRunHistory::IsEnabled() const
+{
+	return !FAutomatronSettings::Get().HistoryFile.IsEmpty();
+}
+
+void FSpecRunHistory::Record(const FString& Key, double Seconds)
+{
+	if (IsEnabled())
+	{
+		Durations.Add(Key, Seconds * 1000.0);
+	}
+}
+
+void FSpecRunHistory::Save()
+{
+	if (!IsEnabled() || Durations.Num() == 0)
+	{
+		return;
+	}
+
+	// Unique even for runs saved in the same second, e.g: shards appending to a shared history
+	const FString Run = FDateTime::UtcNow().ToString(TEXT("%Y%m%d-%H%M%S.%s-")) + FGuid::NewGuid().ToString(EGuidFormats::Digits).Left(8);
+	FString Lines;
+	for (const auto& Duration : Durations)
+	{
+		Lines += FString::Printf(TEXT("%s,%.2f,%s"), *Run, Duration.Value, *Duration.Key) + LINE_TERMINATOR;
+	}
+	Durations.Empty();
+
+	const FString& Path = FAutomatronSettings::Get().HistoryFile;
+	if (!FFileHelper::SaveStringToFile(Lines, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogAutomatron, Warning, TEXT("Failed to save run history to '%s'"), *Path);
+		return;
+	}
+
+	WriteReport();
+}
+
+bool FSpecRunHistory::WriteReport()
+{
+	const FAutomatronSettings& Settings = FAutomatronSettings::Get();
+
+	FComparison Comparison;
+	if (Settings.HistoryFile.IsEmpty() || !Compare(Settings.HistoryFile, Settings, Comparison))
+	{
+		return false;
+	}
+
+	FString Report = TEXT("# Automatron duration regressions") LINE_TERMINATOR LINE_TERMINATOR;
+	Report += FString::Printf(TEXT("Run `%s` compared with up to %i previous runs. %i of %i tests had enough history.") LINE_TERMINATOR,
+		*Comparison.Run, Settings.HistoryRuns, Comparison.NumCompared, Comparison.NumTests);
+	Report += FString::Printf(TEXT("A test regressed if it is %.1f deviations over its median and at least %.0f%% slower.") LINE_TERMINATOR LINE_TERMINATOR,
+		Settings.RegressionDeviations, Settings.RegressionMinChange * 100.0);
+
+	if (Comparison.Regressions.Num() == 0)
+	{
+		Report += TEXT("No regressions.") LINE_TERMINATOR;
+	}
+	else
+	{
+		Report += TEXT("| Test | Duration (ms) | Median (ms) | Deviation (ms) | Change | Runs |") LINE_TERMINATOR;
+		Report += TEXT("|---|---:|---:|---:|---:|---:|") LINE_TERMINATOR;
+		for (const FRegression& Regression : Comparison.Regressions)
+		{
+			const double Change = Regression.Median > 0.0? (Regression.Duration / Regression.Median - 1.0) * 100.0 : 0.0;
+			Report += FString::Printf(TEXT("| %s | %.2f | %.2f | %.2f | +%.0f%% | %i |") LINE_TERMINATOR,
+				*Regression.Key.Replace(TEXT("|"), TEXT("\\|")), Regression.Duration, Regression.Median, Regression.Deviation, Change, Regression.NumRuns);
+
+			UE_LOG(LogAutomatron, Warning, TEXT("Regression: '%s' took %.2fms, median of the last %i runs is %.2fms"),
+				*Regression.Key, Regression.Duration, Regression.NumRuns, Regression.Median);
+		}
+	}
+
+	const FString ReportPath = Settings.RegressionReportFile.IsEmpty()
+		? FPaths::ChangeExtension(Settings.HistoryFile, TEXT("md"))
+		: Settings.RegressionReportFile;
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogAutomatron, Warning, TEXT("Failed to save regression report to '%s'"), *ReportPath);
+		return false;
+	}
+
+	UE_LOG(LogAutomatron, Display, TEXT("Regression report: %i regressions out of %i tests compared. Saved to '%s'"),
+		Comparison.Regressions.Num(), Comparison.NumCompared, *ReportPath);
+	return true;
+}
+
+bool FSpecRunHistory::Compare(const FString& HistoryPath, const FAutomatronSettings& Settings, FComparison& OutComparison)
+{
+	OutComparison = {};
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *HistoryPath) || Lines.Num() == 0)
+	{
+		return false;
+	}
+
+	// Runs in the order they were appended, each with its durations by key
+	TArray<FString> Runs;
+	TArray<TMap<FString, double>> RunDurations;
+	for (const FString& Line : Lines)
+	{
+		int32 FirstComma, SecondComma;
+		if (!Line.FindChar(TEXT(','), FirstComma))
+		{
+			continue;
+		}
+		SecondComma = Line.Find(TEXT(","), ESearchCase::CaseSensitive, ESearchDir::FromStart, FirstComma + 1);
+		if (SecondComma == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FString Run = Line.Left(FirstComma);
+		if (Runs.Num() == 0 || Runs.Last() != Run)
+		{
+			Runs.Add(Run);
+			RunDurations.AddDefaulted();
+		}
+		const double Milliseconds = FCString::Atod(*Line.Mid(FirstComma + 1, SecondComma - FirstComma - 1));
+		RunDurations.Last().Add(Line.Mid(SecondComma + 1), Milliseconds);
+	}
+
+	if (Runs.Num() == 0)
+	{
+		return false;
+	}
+
+	const TMap<FString, double>& LastRun = RunDurations.Last();
+	const int32 FirstCompared = FMath::Max(0, Runs.Num() - 1 - Settings.HistoryRuns);
+	OutComparison.Run = Runs.Last();
+	OutComparison.NumTests = LastRun.Num();
+
+	TArray<double> Previous;
+	for (const auto& Duration : LastRun)
+	{
+		Previous.Reset();
+		for (int32 RunIndex = FirstCompared; RunIndex < Runs.Num() - 1; ++RunIndex)
+		{
+			if (const double* Value = RunDurations[RunIndex].Find(Duration.Key))
+			{
+				Previous.Add(*Value);
+			}
+		}
+
+		if (Previous.Num() < MinRunsToCompare)
+		{
+			continue;
+		}
+		++OutComparison.NumCompared;
+
+		FRegression Regression;
+		Regression.Key = Duration.Key;
+		Regression.Duration = Duration.Value;
+		Regression.NumRuns = Previous.Num();
+		GetMedianAndDeviation(Previous, Regression.Median, Regression.Deviation);
+
+		// Slower than the usual noise of this test, and by a meaningful amount
+		const bool bOverNoise = Regression.Duration > Regression.Median + Settings.RegressionDeviations * Regression.Deviation;
+		const bool bOverMinChange = Regression.Duration > Regression.Median * (1.0 + Settings.RegressionMinChange);
+		if (bOverNoise && bOverMinChange)
+		{
+			OutComparison.Regressions.Add(MoveTemp(Regression));
+		}
+	}
+
+	OutComparison.Regressions.Sort([](const FRegression& A, const FRegression& B)
+	{
+		return (A.Duration - A.Median) > (B.Duration - B.Median);
+	});
+	return true;
+}
+
+void FSpecRunHistory::GetMedianAndDeviation(TArray<double> Values, double& OutMedian, double& OutDeviation)
+{
+	auto Median = [](TArray<double>& Sorted)
+	{
+		Sorted.Sort();
+		const int32 Middle = Sorted.Num() / 2;
+		return (Sorted.Num() % 2 == 0)? (Sorted[Middle - 1] + Sorted[Middle]) * 0.5 : Sorted[Middle];
+	};
+
+	OutMedian = Median(Values);
+	for (double& Value : Values)
+	{
+		Value = FMath::Abs(Value - OutMedian);
+	}
+	OutDeviation = Median(Values) * MADScale;
+}
@@ -0,0 +1,70 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/RunStats.h"
+#include "Misc/Log.h"
+
+#if PLATFORM_WINDOWS
+#include <Windows/AllowWindowsPlatformTypes.h>
+#include <processthreadsapi.h>
+#include <Windows/HideWindowsPlatformTypes.h>
+#elif PLATFORM_UNIX || PLATFORM_MAC
+#include <sys/resource.h>
+#endif
+
+
+FAutomatronRunStats& FAutomatronRunStats::Get()
+{
+	static FAutomatronRunStats Stats;
+	return Stats;
+}
+
+void FAutomatronRunStats::Report() const
+{
+	const double WallSeconds = FPlatformTime::Seconds() - StartSeconds;
+	const double CPUSeconds = GetProcessCPUSeconds() - StartCPUSeconds;
+	if (StartSeconds > 0.0 && WallSeconds > 0.0 && CPUSeconds >= 0.0)
+	{
+		// 100% is one core fully used
+		UE_LOG(LogAutomatron, Display, TEXT("CPU: %.1f%% average usage over %.2fs (%.2fs of CPU time). Slept %.2fs while tests waited"),
+			100.0 * CPUSeconds / WallSeconds, WallSeconds, CPUSeconds, SleptSeconds);
+	}
+
+	if (Retries == 0 && QuarantinedFailures == 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogAutomatron, Display, TEXT("Retries: %i attempts retried costing %.2fs, %i tests passed on retry"), Retries, RetriedSeconds, PassedOnRetry);
+	UE_LOG(LogAutomatron, Display, TEXT("Quarantine: %i quarantined tests failed without failing the run"), QuarantinedFailures);
+}
+
+void FAutomatronRunStats::Reset()
+{
+	*this = {};
+	StartSeconds = FPlatformTime::Seconds();
+	StartCPUSeconds = GetProcessCPUSeconds();
+}
+
+double FAutomatronRunStats::GetProcessCPUSeconds()
+{
+#if PLATFORM_WINDOWS
+	FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+	if (::GetProcessTimes(::GetCurrentProcess(), &CreationTime, &ExitTime, &KernelTime, &UserTime))
+	{
+		auto ToSeconds = [](const FILETIME& Time)
+		{
+			// 100 nanosecond units
+			return double((uint64(Time.dwHighDateTime) << 32) | Time.dwLowDateTime) * 1e-7;
+		};
+		return ToSeconds(KernelTime) + ToSeconds(UserTime);
+	}
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	struct rusage Usage;
+	if (getrusage(RUSAGE_SELF, &Usage) == 0)
+	{
+		return Usage.ru_utime.tv_sec + Usage.ru_utime.tv_usec * 1e-6
+			+ Usage.ru_stime.tv_sec + Usage.ru_stime.tv_usec * 1e-6;
+	}
+#endif
+	return 0.0;
+}
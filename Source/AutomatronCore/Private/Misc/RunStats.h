@@ -0,0 +1,37 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Accounting of a whole automation run. Only used from the game thread
+struct FAutomatronRunStats
+{
+	int32 Retries = 0;
+	int32 PassedOnRetry = 0;
+	int32 QuarantinedFailures = 0;
+
+	// Failed tests, excluding quarantined ones
+	int32 Failures = 0;
+	TMap<FString, int32> FailuresBySpec;
+
+	// Time spent in attempts that failed and were retried
+	double RetriedSeconds = 0.0;
+
+	// Time the game thread slept while tests waited. See FTestSpecBase::SleepWhileWaiting
+	double SleptSeconds = 0.0;
+
+	// When the run started, in wall and process CPU time
+	double StartSeconds = 0.0;
+	double StartCPUSeconds = 0.0;
+
+
+	static FAutomatronRunStats& Get();
+
+	void Report() const;
+	void Reset();
+
+	// User and kernel time of all threads of the process
+	static double GetProcessCPUSeconds();
+};
@@ -0,0 +1,255 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/Snapshot.h"
+#include <HAL/FileManager.h>
+#include <Hash/CityHash.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+
+
+namespace
+{
+	constexpr int32 ChunkSize = 64 * 1024;
+
+	// Differences described on a mismatch. Large diffs are cut to keep reports readable
+	constexpr int32 MaxReportedDiffs = 8;
+	constexpr int32 MaxReportedBytes = 16;
+}
+
+
+FSpecSnapshot::FSpecSnapshot(const FString& SourceFile, const FString& TestName, const FString& Name)
+{
+	const FString SafeTestName = FPaths::MakeValidFileName(TestName);
+	const FString FileName = FPaths::MakeValidFileName(Name) + TEXT(".snap");
+	Path = FPaths::GetPath(SourceFile) / TEXT("Snapshots") / SafeTestName / FileName;
+	ReceivedPath = FPaths::ProjectSavedDir() / TEXT("Automation") / TEXT("Snapshots") / SafeTestName / FileName;
+}
+
+FSpecSnapshot::EResult FSpecSnapshot::Compare(TArrayView<const uint8> Data, EFormat Format, bool bUpdate)
+{
+	Report.Empty();
+
+	if (!FPaths::FileExists(Path))
+	{
+		if (!Write(Data))
+		{
+			Report = FString::Printf(TEXT("Failed to create snapshot '%s'"), *Path);
+			return EResult::Failed;
+		}
+		return EResult::Created;
+	}
+
+	TArray<uint64> ActualHashes;
+	HashChunks(Data, ActualHashes);
+
+	int64 ExpectedSize = 0;
+	TArray<uint64> ExpectedHashes;
+	if (!ReadHashes(ExpectedSize, ExpectedHashes))
+	{
+		// Snapshot added by hand. Hash it once, next runs won't need to read it
+		TArray<uint8> Expected;
+		if (!FFileHelper::LoadFileToArray(Expected, *Path))
+		{
+			Report = FString::Printf(TEXT("Failed to read snapshot '%s'"), *Path);
+			return EResult::Failed;
+		}
+		ExpectedSize = Expected.Num();
+		HashChunks(Expected, ExpectedHashes);
+		WriteHashes(ExpectedSize, ExpectedHashes);
+	}
+
+	if (ExpectedSize == Data.Num() && ExpectedHashes == ActualHashes)
+	{
+		return EResult::Matched;
+	}
+
+	if (bUpdate)
+	{
+		if (!Write(Data))
+		{
+			Report = FString::Printf(TEXT("Failed to update snapshot '%s'"), *Path);
+			return EResult::Failed;
+		}
+		return EResult::Updated;
+	}
+
+	int32 FirstChunk = 0;
+	while (FirstChunk < ExpectedHashes.Num() && FirstChunk < ActualHashes.Num() && ExpectedHashes[FirstChunk] == ActualHashes[FirstChunk])
+	{
+		++FirstChunk;
+	}
+
+	// Only now the snapshot itself is needed
+	TArray<uint8> Expected;
+	if (!FFileHelper::LoadFileToArray(Expected, *Path))
+	{
+		Report = FString::Printf(TEXT("Failed to read snapshot '%s'"), *Path);
+		return EResult::Failed;
+	}
+
+	if (Format == EFormat::Text)
+	{
+		DescribeTextDiff(Expected, Data);
+	}
+	else
+	{
+		DescribeBinaryDiff(Expected, Data, FirstChunk);
+	}
+
+	if (FFileHelper::SaveArrayToFile(Data, *ReceivedPath))
+	{
+		Report += FString::Printf(TEXT("\n  Received data saved to '%s'"), *ReceivedPath);
+	}
+	return EResult::Mismatched;
+}
+
+bool FSpecSnapshot::Write(TArrayView<const uint8> Data) const
+{
+	TArray<uint64> Hashes;
+	HashChunks(Data, Hashes);
+	return FFileHelper::SaveArrayToFile(Data, *Path) && WriteHashes(Data.Num(), Hashes);
+}
+
+bool FSpecSnapshot::WriteHashes(int64 Size, const TArray<uint64>& Hashes) const
+{
+	FString HashFile = FString::Printf(TEXT("%lld"), Size) + LINE_TERMINATOR;
+	for (uint64 Hash : Hashes)
+	{
+		HashFile += FString::Printf(TEXT("%016llx"), Hash) + LINE_TERMINATOR;
+	}
+	return FFileHelper::SaveStringToFile(HashFile, *GetHashPath(Path));
+}
+
+bool FSpecSnapshot::ReadHashes(int64& OutSize, TArray<uint64>& OutHashes) const
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *GetHashPath(Path)) || Lines.Num() == 0)
+	{
+		return false;
+	}
+
+	// A snapshot edited after its hashes were written can't be trusted to them
+	if (IFileManager::Get().GetTimeStamp(*Path) > IFileManager::Get().GetTimeStamp(*GetHashPath(Path)))
+	{
+		return false;
+	}
+
+	OutSize = FCString::Atoi64(*Lines[0]);
+	OutHashes.Reset(Lines.Num() - 1);
+	for (int32 I = 1; I < Lines.Num(); ++I)
+	{
+		OutHashes.Add(FCString::Strtoui64(*Lines[I], nullptr, 16));
+	}
+	return true;
+}
+
+void FSpecSnapshot::DescribeBinaryDiff(TArrayView<const uint8> Expected, TArrayView<const uint8> Actual, int32 FirstChunk)
+{
+	Report = FString::Printf(TEXT("Snapshot '%s' doesn't match. Expected %i bytes, got %i"),
+		*FPaths::GetBaseFilename(Path), Expected.Num(), Actual.Num());
+
+	const int32 CommonSize = FMath::Min(Expected.Num(), Actual.Num());
+	int32 NumDiffs = 0;
+	int32 Offset = FirstChunk * ChunkSize;
+	while (Offset < CommonSize)
+	{
+		// Skip identical chunks at once
+		if (Offset % ChunkSize == 0)
+		{
+			const int32 Size = FMath::Min(ChunkSize, CommonSize - Offset);
+			if (FMemory::Memcmp(Expected.GetData() + Offset, Actual.GetData() + Offset, Size) == 0)
+			{
+				Offset += Size;
+				continue;
+			}
+		}
+
+		if (Expected[Offset] == Actual[Offset])
+		{
+			++Offset;
+			continue;
+		}
+
+		int32 End = Offset + 1;
+		while (End < CommonSize && Expected[End] != Actual[End])
+		{
+			++End;
+		}
+
+		if (NumDiffs == MaxReportedDiffs)
+		{
+			Report += TEXT("\n  ...");
+			break;
+		}
+		++NumDiffs;
+
+		const int32 Shown = FMath::Min(End - Offset, MaxReportedBytes);
+		Report += FString::Printf(TEXT("\n  0x%08x (%i bytes): expected %s%s, got %s%s"), Offset, End - Offset,
+			*BytesToHex(Expected.GetData() + Offset, Shown), (End - Offset > Shown)? TEXT("...") : TEXT(""),
+			*BytesToHex(Actual.GetData() + Offset, Shown), (End - Offset > Shown)? TEXT("...") : TEXT(""));
+		Offset = End;
+	}
+
+	if (Expected.Num() != Actual.Num())
+	{
+		Report += FString::Printf(TEXT("\n  0x%08x: %i bytes %s"), CommonSize,
+			FMath::Abs(Expected.Num() - Actual.Num()), (Actual.Num() > Expected.Num())? TEXT("added") : TEXT("missing"));
+	}
+}
+
+void FSpecSnapshot::DescribeTextDiff(TArrayView<const uint8> Expected, TArrayView<const uint8> Actual)
+{
+	const FUTF8ToTCHAR ExpectedConverter((const ANSICHAR*)Expected.GetData(), Expected.Num());
+	const FUTF8ToTCHAR ActualConverter((const ANSICHAR*)Actual.GetData(), Actual.Num());
+	const FString ExpectedText(ExpectedConverter.Length(), ExpectedConverter.Get());
+	const FString ActualText(ActualConverter.Length(), ActualConverter.Get());
+
+	TArray<FString> ExpectedLines;
+	TArray<FString> ActualLines;
+	ExpectedText.ParseIntoArrayLines(ExpectedLines, false);
+	ActualText.ParseIntoArrayLines(ActualLines, false);
+
+	Report = FString::Printf(TEXT("Snapshot '%s' doesn't match"), *FPaths::GetBaseFilename(Path));
+
+	int32 NumDiffs = 0;
+	const int32 NumLines = FMath::Max(ExpectedLines.Num(), ActualLines.Num());
+	for (int32 Line = 0; Line < NumLines; ++Line)
+	{
+		const FString* ExpectedLine = ExpectedLines.IsValidIndex(Line)? &ExpectedLines[Line] : nullptr;
+		const FString* ActualLine = ActualLines.IsValidIndex(Line)? &ActualLines[Line] : nullptr;
+		if (ExpectedLine && ActualLine && ExpectedLine->Equals(*ActualLine, ESearchCase::CaseSensitive))
+		{
+			continue;
+		}
+
+		if (NumDiffs == MaxReportedDiffs)
+		{
+			Report += TEXT("\n  ...");
+			break;
+		}
+		++NumDiffs;
+
+		if (!ActualLine)
+		{
+			Report += FString::Printf(TEXT("\n  %i: missing '%s'"), Line + 1, **ExpectedLine);
+		}
+		else if (!ExpectedLine)
+		{
+			Report += FString::Printf(TEXT("\n  %i: added '%s'"), Line + 1, **ActualLine);
+		}
+		else
+		{
+			Report += FString::Printf(TEXT("\n  %i: expected '%s', got '%s'"), Line + 1, **ExpectedLine, **ActualLine);
+		}
+	}
+}
+
+void FSpecSnapshot::HashChunks(TArrayView<const uint8> Data, TArray<uint64>& OutHashes)
+{
+	OutHashes.Reset(FMath::DivideAndRoundUp(Data.Num(), ChunkSize));
+	for (int32 Offset = 0; Offset < Data.Num(); Offset += ChunkSize)
+	{
+		const int32 Size = FMath::Min(ChunkSize, Data.Num() - Offset);
+		OutHashes.Add(CityHash64((const char*)Data.GetData() + Offset, Size));
+	}
+}
@@ -0,0 +1,240 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "Misc/SpecTags.h"
+
+#include "AutomatronSettings.h"
+#include "Misc/Log.h"
+
+
+FSpecTagIndex& FSpecTagIndex::Get()
+{
+	static FSpecTagIndex Index;
+	return Index;
+}
+
+int32 FSpecTagIndex::FindOrAdd(const FString& Tag)
+{
+	// Tags are case insensitive
+	const FString Key = Tag.ToLower();
+	if (const int32* Bit = Bits.Find(Key))
+	{
+		return *Bit;
+	}
+	return Bits.Add(Key, Bits.Num());
+}
+
+TBitArray<> FSpecTagIndex::MakeBits(const TArray<FString>& Tags)
+{
+	TBitArray<> TagBits;
+	for (const FString& Tag : Tags)
+	{
+		const int32 Bit = FindOrAdd(Tag);
+		if (Bit >= TagBits.Num())
+		{
+			TagBits.Add(false, Bit + 1 - TagBits.Num());
+		}
+		TagBits[Bit] = true;
+	}
+	return TagBits;
+}
+
+
+// Recursive descent parser emitting postfix instructions
+struct FSpecTagQuery::FParser
+{
+	const FString& Query;
+	TArray<FInstruction>& Instructions;
+	int32 Position = 0;
+	FString Error;
+
+	FParser(const FString& InQuery, TArray<FInstruction>& OutInstructions)
+		: Query(InQuery)
+		, Instructions(OutInstructions)
+	{}
+
+	bool ParseOr()
+	{
+		if (!ParseAnd())
+		{
+			return false;
+		}
+		while (Consume(TEXT('|')))
+		{
+			if (!ParseAnd())
+			{
+				return false;
+			}
+			Instructions.Add({ EOp::Or, INDEX_NONE });
+		}
+		return true;
+	}
+
+	bool ParseAnd()
+	{
+		if (!ParseUnary())
+		{
+			return false;
+		}
+		while (Consume(TEXT('&')))
+		{
+			if (!ParseUnary())
+			{
+				return false;
+			}
+			Instructions.Add({ EOp::And, INDEX_NONE });
+		}
+		return true;
+	}
+
+	bool ParseUnary()
+	{
+		if (Consume(TEXT('!')))
+		{
+			if (!ParseUnary())
+			{
+				return false;
+			}
+			Instructions.Add({ EOp::Not, INDEX_NONE });
+			return true;
+		}
+
+		if (Consume(TEXT('(')))
+		{
+			if (!ParseOr())
+			{
+				return false;
+			}
+			if (!Consume(TEXT(')')))
+			{
+				return Fail(TEXT("expected ')'"));
+			}
+			return true;
+		}
+
+		SkipSpaces();
+		const int32 Start = Position;
+		while (Position < Query.Len() && IsTagChar(Query[Position]))
+		{
+			++Position;
+		}
+		if (Position == Start)
+		{
+			return Fail(TEXT("expected a tag"));
+		}
+
+		Instructions.Add({ EOp::Tag, FSpecTagIndex::Get().FindOrAdd(Query.Mid(Start, Position - Start)) });
+		return true;
+	}
+
+	bool Consume(TCHAR Char)
+	{
+		SkipSpaces();
+		if (Position < Query.Len() && Query[Position] == Char)
+		{
+			++Position;
+			return true;
+		}
+		return false;
+	}
+
+	void SkipSpaces()
+	{
+		while (Position < Query.Len() && FChar::IsWhitespace(Query[Position]))
+		{
+			++Position;
+		}
+	}
+
+	bool IsAtEnd()
+	{
+		SkipSpaces();
+		return Position >= Query.Len();
+	}
+
+	bool Fail(const TCHAR* Message)
+	{
+		Error = FString::Printf(TEXT("%s at character %i"), Message, Position + 1);
+		return false;
+	}
+
+	static bool IsTagChar(TCHAR Char)
+	{
+		return FChar::IsAlnum(Char) || Char == TEXT('_') || Char == TEXT('-') || Char == TEXT('.');
+	}
+};
+
+
+const FSpecTagQuery& FSpecTagQuery::Get()
+{
+	static FSpecTagQuery Query = []()
+	{
+		FSpecTagQuery NewQuery;
+		const FString& QueryString = FAutomatronSettings::Get().TagQuery;
+		FString Error;
+		if (!NewQuery.Parse(QueryString, Error))
+		{
+			UE_LOG(LogAutomatron, Error, TEXT("Invalid tag query '%s': %s. No tests will be selected"), *QueryString, *Error);
+		}
+		return NewQuery;
+	}();
+	return Query;
+}
+
+bool FSpecTagQuery::Parse(const FString& Query, FString& OutError)
+{
+	Instructions.Reset();
+	bValid = true;
+
+	FParser Parser{ Query, Instructions };
+	if (Parser.IsAtEnd())
+	{
+		return true;
+	}
+
+	if (!Parser.ParseOr() || (!Parser.IsAtEnd() && !Parser.Fail(TEXT("unexpected character"))))
+	{
+		OutError = Parser.Error;
+		Instructions.Reset();
+		bValid = false;
+	}
+	return bValid;
+}
+
+bool FSpecTagQuery::Matches(const TBitArray<>& TagBits) const
+{
+	if (!bValid)
+	{
+		return false;
+	}
+	if (Instructions.Num() == 0)
+	{
+		return true;
+	}
+
+	TArray<bool, TInlineAllocator<16>> Stack;
+	for (const FInstruction& Instruction : Instructions)
+	{
+		switch (Instruction.Op)
+		{
+		case EOp::Tag:
+			Stack.Push(Instruction.Bit < TagBits.Num() && TagBits[Instruction.Bit]);
+			break;
+		case EOp::Not:
+			Stack.Last() = !Stack.Last();
+			break;
+		case EOp::And:
+		{
+			const bool bRight = Stack.Pop(false);
+			Stack.Last() = Stack.Last() && bRight;
+			break;
+		}
+		case EOp::Or:
+		{
+			const bool bRight = Stack.Pop(false);
+			Stack.Last() = Stack.Last() || bRight;
+			break;
+		}
+		}
+	}
+	return Stack.Last();
+}
@@ -0,0 +1,41 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Misc/AutomationTest.h>
+
+#include "CoreTestSpec.h"
+
+
+// Name of the module being compiled, defined by UnrealBuildTool
+#ifdef UE_MODULE_NAME
+#define AUTOMATRON_MODULE_NAME TEXT(UE_MODULE_NAME)
+#else
+#define AUTOMATRON_MODULE_NAME TEXT("")
+#endif
+
+#define GENERATE_SPEC(TClass, PrettyName, TFlags) \
+	GENERATE_SPEC_PRIVATE(TClass, PrettyName, TFlags, __FILE__, __LINE__)
+
+#define GENERATE_SPEC_PRIVATE(TClass, PrettyName, TFlags, FileName, LineNumber) \
+private: \
+	void Setup() \
+	{ \
+		FCoreTestSpec::Setup<TFlags>(TEXT(#TClass), TEXT(PrettyName), FileName, LineNumber, AUTOMATRON_MODULE_NAME); \
+	} \
+    static TSpecRegister<TClass>& __meta_register() \
+	{ \
+        return TSpecRegister<TClass>::Register; \
+    } \
+	friend TSpecRegister<TClass>; \
+\
+	virtual void Define() override
+
+
+#define SPEC(TClass, TParent, PrettyName, TFlags) \
+class TClass : public TParent \
+{ \
+	GENERATE_SPEC(TClass, PrettyName, TFlags); \
+}; \
+void TClass::Define()
@@ -0,0 +1,22 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Modules/ModuleManager.h>
+
+
+class FAutomatronCoreModule : public IModuleInterface
+{
+	FDelegateHandle OnBeforeAllTestsHandle;
+	FDelegateHandle OnAfterAllTestsHandle;
+	FDelegateHandle OnModulesChangedHandle;
+	FDelegateHandle OnPatchCompleteHandle;
+
+public:
+
+	/** Begin IModuleInterface implementation */
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+	/** End IModuleInterface implementation */
+};
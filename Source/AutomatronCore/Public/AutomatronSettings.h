@@ -0,0 +1,113 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Run options for Automatron, read once from the command line
+// E.g: -Automatron.Stress="Automatron Can run a test" -Automatron.StressRuns=500
+struct AUTOMATRONCORE_API FAutomatronSettings
+{
+	// Spec ids to stress. Entries ending in '*' match any id with that prefix
+	TArray<FString> StressSpecs;
+
+	// How many times stressed specs will run. Zero when only StressSeconds is used
+	int32 StressRuns = 0;
+
+	// For how long stressed specs will keep running
+	double StressSeconds = 0.0;
+
+	// If true, the order of stressed specs is randomized on every run
+	bool bStressShuffle = false;
+
+	// Seed of the first stress run. Each run uses Seed + RunIndex
+	int32 StressSeed = 0;
+
+	// File listing quarantined spec ids, one per line. Failures of quarantined specs are reported as warnings
+	FString QuarantineFile;
+
+	TArray<FString> QuarantinedSpecs;
+
+	// Impact map used to only run specs affected by ChangedFilesFile. See FSpecImpactMap
+	FString ImpactMapFile;
+	FString ChangedFilesFile;
+
+	// Where to save the impact map of this run
+	FString RecordImpactMapFile;
+
+	// Only specs whose tags match this query run. E.g: -Automatron.Tags="net & !slow". See FSpecTagQuery
+	FString TagQuery;
+
+	// If true, specs that can be cached and already passed with the same inputs are not run again
+	bool bResultCache = false;
+
+	// Ignores cached results, running every spec
+	bool bForceRun = false;
+
+	FString ResultCacheFile;
+
+	// Reports written as specs finish. See FSpecResultReporter
+	FString JUnitReportFile;
+	FString JsonReportFile;
+
+	// Durations of every run are appended here. Empty disables the history. See FSpecRunHistory
+	FString HistoryFile;
+
+	// Previous runs a test is compared with to detect regressions
+	int32 HistoryRuns = 10;
+
+	// A test regressed if it is this many deviations over its median duration...
+	double RegressionDeviations = 3.0;
+	// ...and slower by at least this fraction of the median
+	double RegressionMinChange = 0.1;
+
+	// Markdown regression report. Defaults to HistoryFile with .md extension
+	FString RegressionReportFile;
+
+	// Markdown report of the shape and definition cost of every spec. See FSpecBakeReport
+	FString BakeReportFile;
+
+	// Log lines kept in memory while tests run, to attach to failed tests
+	int32 LogCaptureCapacity = 8192;
+
+	// Longest the game thread sleeps per frame while a test waits on latent work. Zero polls every frame.
+	// An attended editor caps its frame rate to IdleFrameRate instead, so it stays interactive
+	int32 IdleSleepMs = 20;
+
+	// Frame rate of an attended editor while a test waits on latent work. Zero doesn't cap it
+	int32 IdleFrameRate = 30;
+
+	// Where frame captures are exported. See FTestSpec::ExportFrameCapture
+	FString FrameCaptureDir;
+
+	// Rewrites snapshots that don't match instead of failing. See FTestSpecBase::TestMatchesSnapshot
+	bool bUpdateSnapshots = false;
+
+	// Size on disk of the maps kept loaded across specs. See FTestSpec::TestMap
+	int32 MapCacheMB = 2048;
+
+	// Fraction of a latent command's timeout after which callstacks are captured. Zero disables it
+	float HangDumpFraction = 0.8f;
+
+	// Failures after which remaining tests are skipped. Zero disables fail-fast
+	int32 MaxFailures = 0;
+
+	// If true, MaxFailures counts failures of the whole run. Otherwise they are counted per spec
+	bool bFailFastWholeRun = true;
+
+
+	static const FAutomatronSettings& Get();
+
+	bool IsStressed(const FString& SpecId) const { return MatchesAny(StressSpecs, SpecId); }
+	bool IsQuarantined(const FString& SpecId) const { return MatchesAny(QuarantinedSpecs, SpecId); }
+	bool IsFailFastEnabled() const { return MaxFailures > 0; }
+	bool IsStressEnabled() const { return StressSpecs.Num() > 0 && (StressRuns > 0 || StressSeconds > 0.0); }
+
+private:
+
+	void Parse(const TCHAR* CommandLine);
+	void LoadQuarantine();
+
+	static bool MatchesAny(const TArray<FString>& Selectors, const FString& SpecId);
+};
@@ -0,0 +1,210 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Async/Future.h>
+#include <CoreGlobals.h>
+#include <Misc/AutomationTest.h>
+
+
+// Coroutines require C++20. Modules compiled with an older standard simply don't see AsyncIt.
+#ifndef AUTOMATRON_WITH_COROUTINES
+#	if defined(__cpp_impl_coroutine) && defined(__has_include)
+#		if __has_include(<coroutine>)
+#			define AUTOMATRON_WITH_COROUTINES 1
+#		endif
+#	endif
+#endif
+
+#ifndef AUTOMATRON_WITH_COROUTINES
+#	define AUTOMATRON_WITH_COROUTINES 0
+#endif
+
+
+#if AUTOMATRON_WITH_COROUTINES
+
+#include <coroutine>
+
+
+// What a suspended spec coroutine is waiting on.
+// Points into an awaiter living inside the coroutine frame, so suspending never allocates.
+struct FSpecAwaitState
+{
+	bool (*IsReady)(const void* Awaiter) = nullptr;
+	const void* Awaiter = nullptr;
+
+	bool CanResume() const { return !IsReady || IsReady(Awaiter); }
+};
+
+
+// Return type of the bodies passed to AsyncIt. Owns the coroutine frame.
+class FSpecCoroutine
+{
+public:
+
+	struct promise_type
+	{
+		FSpecAwaitState Await;
+
+		FSpecCoroutine get_return_object() { return FSpecCoroutine{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { checkNoEntry(); }
+	};
+
+private:
+
+	std::coroutine_handle<promise_type> Handle;
+
+
+public:
+
+	FSpecCoroutine() = default;
+	explicit FSpecCoroutine(std::coroutine_handle<promise_type> InHandle) : Handle(InHandle) {}
+	FSpecCoroutine(FSpecCoroutine&& Other) : Handle(Other.Handle) { Other.Handle = nullptr; }
+	FSpecCoroutine& operator=(FSpecCoroutine&& Other)
+	{
+		if (this != &Other)
+		{
+			Reset();
+			Handle = Other.Handle;
+			Other.Handle = nullptr;
+		}
+		return *this;
+	}
+	FSpecCoroutine(const FSpecCoroutine&) = delete;
+	FSpecCoroutine& operator=(const FSpecCoroutine&) = delete;
+	~FSpecCoroutine() { Reset(); }
+
+	bool IsValid() const { return (bool)Handle; }
+
+	// Resumes the coroutine if whatever it awaits is ready. Returns true once the body has finished.
+	bool Resume()
+	{
+		check(Handle);
+		if (Handle.done())
+		{
+			return true;
+		}
+
+		promise_type& Promise = Handle.promise();
+		if (!Promise.Await.CanResume())
+		{
+			return false;
+		}
+
+		Promise.Await = {};
+		Handle.resume();
+		return Handle.done();
+	}
+
+	void Reset()
+	{
+		if (Handle)
+		{
+			Handle.destroy();
+			Handle = nullptr;
+		}
+	}
+};
+
+
+// Base of all awaiters usable inside an AsyncIt body. TAwaiter must implement 'bool IsReady() const'
+template<typename TAwaiter>
+struct TSpecAwaiter
+{
+	bool await_ready() const { return static_cast<const TAwaiter*>(this)->IsReady(); }
+
+	void await_suspend(std::coroutine_handle<FSpecCoroutine::promise_type> Handle)
+	{
+		Handle.promise().Await = { &TSpecAwaiter::Poll, this };
+	}
+
+	void await_resume() {}
+
+private:
+
+	static bool Poll(const void* Self)
+	{
+		return static_cast<const TSpecAwaiter*>(Self)->await_ready();
+	}
+};
+
+
+struct FSpecNextFrameAwaiter : public TSpecAwaiter<FSpecNextFrameAwaiter>
+{
+	const uint64 Frame = GFrameCounter;
+
+	bool IsReady() const { return GFrameCounter > Frame; }
+};
+
+
+struct FSpecDelayAwaiter : public TSpecAwaiter<FSpecDelayAwaiter>
+{
+	const double EndTime;
+
+	FSpecDelayAwaiter(const FTimespan& Duration) : EndTime(FPlatformTime::Seconds() + Duration.GetTotalSeconds()) {}
+
+	bool IsReady() const { return FPlatformTime::Seconds() >= EndTime; }
+};
+
+
+template<typename TPredicate>
+struct TSpecConditionAwaiter : public TSpecAwaiter<TSpecConditionAwaiter<TPredicate>>
+{
+	TPredicate Predicate;
+
+	TSpecConditionAwaiter(TPredicate&& InPredicate) : Predicate(MoveTemp(InPredicate)) {}
+
+	bool IsReady() const { return Predicate(); }
+};
+
+
+template<typename ResultType>
+struct TSpecFutureAwaiter : public TSpecAwaiter<TSpecFutureAwaiter<ResultType>>
+{
+	TFuture<ResultType> Future;
+
+	TSpecFutureAwaiter(TFuture<ResultType>&& InFuture) : Future(MoveTemp(InFuture)) {}
+
+	bool IsReady() const { return Future.IsReady(); }
+
+	decltype(auto) await_resume() { return Future.Get(); }
+};
+
+
+// Can be awaited until triggered. Triggering is thread-safe, so it can be bound to any delegate.
+class FSpecSignal : public TSpecAwaiter<FSpecSignal>
+{
+	struct FState
+	{
+		FThreadSafeBool bTriggered;
+	};
+
+	// Shared with the delegates handed out, which can fire after the coroutine awaiting them timed out or was destroyed
+	TSharedRef<FState, ESPMode::ThreadSafe> State;
+
+public:
+
+	FSpecSignal() : State(MakeShared<FState, ESPMode::ThreadSafe>()) {}
+
+	void Trigger() { State->bTriggered = true; }
+
+	// Delegates handed out before a reset can't trigger the signal anymore
+	void Reset() { State = MakeShared<FState, ESPMode::ThreadSafe>(); }
+
+	// Bridges callback style APIs (like LatentIt bodies) into a coroutine
+	FDoneDelegate AsDoneDelegate()
+	{
+		return FDoneDelegate::CreateLambda([State = State]()
+		{
+			State->bTriggered = true;
+		});
+	}
+
+	bool IsReady() const { return State->bTriggered; }
+};
+
+#endif //AUTOMATRON_WITH_COROUTINES
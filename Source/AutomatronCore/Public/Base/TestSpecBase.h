@@ -0,0 +1,1178 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Containers/Queue.h>
+#include <HAL/ThreadSafeCounter64.h>
+#include <Misc/AutomationTest.h>
+
+#include "Base/SpecCoroutine.h"
+#include "Misc/SpecMock.h"
+
+struct FSpecBakeEntry;
+class FSpecTagQuery;
+
+
+struct AUTOMATRONCORE_API FTestContext
+{
+private:
+
+	int32 Id = 0;
+
+public:
+	FTestContext(int32 Id = 0) : Id(Id) {}
+
+	FTestContext NextContext() const { return { Id + 1 }; }
+	int32 GetId() const { return Id; }
+
+	friend uint32 GetTypeHash(const FTestContext& Item) { return Item.Id; }
+	bool operator==(const FTestContext& Other) const { return Id == Other.Id; }
+	operator bool() const { return Id > 0; }
+};
+
+
+// Tags of a Describe or It, inherited by everything inside it. Select tests with -Automatron.Tags=<query>
+// E.g: It("Replicates", Tags{"net", "slow"}, [this]() { ... });
+struct FSpecTags
+{
+	TArray<FString> Names;
+
+	FSpecTags() {}
+	FSpecTags(std::initializer_list<FString> InNames) : Names(InNames) {}
+};
+
+
+// Per test settings that can be passed to It and LatentIt
+// E.g: It("Flaky test", FSpecItOptions().Retries(2), [this]() { ... });
+struct FSpecItOptions
+{
+	// How many more times the test will run if it fails
+	int32 MaxRetries = 0;
+
+	FSpecTags Tags;
+
+	FSpecItOptions() {}
+	// Allows passing tags directly instead of options
+	FSpecItOptions(FSpecTags InTags) : Tags(MoveTemp(InTags)) {}
+
+	FSpecItOptions& Retries(int32 InMaxRetries)
+	{
+		MaxRetries = FMath::Max(0, InMaxRetries);
+		return *this;
+	}
+
+	FSpecItOptions& WithTags(FSpecTags InTags)
+	{
+		Tags.Names.Append(MoveTemp(InTags.Names));
+		return *this;
+	}
+};
+
+
+class AUTOMATRONCORE_API FTestSpecBase
+	: public FAutomationTestBase
+	, public TSharedFromThis<FTestSpecBase>
+{
+private:
+
+	class FSingleExecuteLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		const FTestSpecBase* const Spec;
+		const TFunction<void()> Predicate;
+		const bool bSkipIfErrored;
+
+	public:
+		FSingleExecuteLatentCommand(FTestSpecBase* const InSpec, TFunction<void()> InPredicate, bool bInSkipIfErrored = false)
+			: Spec(InSpec)
+			, Predicate(MoveTemp(InPredicate))
+			, bSkipIfErrored(bInSkipIfErrored)
+		{
+			InSpec->ImmediateCommands.Add(this);
+		}
+		virtual ~FSingleExecuteLatentCommand() {}
+
+		virtual bool Update() override;
+	};
+
+	class FUntilDoneLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		FTestSpecBase* const Spec;
+		const TFunction<void(const FDoneDelegate&)> Predicate;
+		const FTimespan Timeout;
+		const bool bSkipIfErrored;
+
+		bool bIsRunning;
+		FDateTime StartedRunning;
+		FThreadSafeBool bDone;
+		// Increased on every reset, so that abandoned runs can't complete later ones
+		FThreadSafeCounter Generation;
+
+	public:
+
+		FUntilDoneLatentCommand(FTestSpecBase* const InSpec, TFunction<void(const FDoneDelegate&)> InPredicate, const FTimespan& InTimeout, bool bInSkipIfErrored = false)
+			: Spec(InSpec)
+			, Predicate(MoveTemp(InPredicate))
+			, Timeout(InTimeout)
+			, bSkipIfErrored(bInSkipIfErrored)
+			, bIsRunning(false)
+			, bDone(false)
+		{}
+		virtual ~FUntilDoneLatentCommand() {}
+
+		virtual bool Update() override;
+
+	private:
+
+		void Done(int32 InGeneration)
+		{
+			if (InGeneration == Generation.GetValue())
+			{
+				bDone = true;
+				FTestSpecBase::WakeUp();
+			}
+		}
+
+		void Reset()
+		{
+			// Reset the done for the next potential run of this command
+			bDone = false;
+			Generation.Increment();
+			Spec->EndHangWatch();
+			bIsRunning = false;
+		}
+	};
+
+	class FAsyncUntilDoneLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		FTestSpecBase* const Spec;
+		const EAsyncExecution Execution;
+		const TFunction<void(const FDoneDelegate&)> Predicate;
+		const FTimespan Timeout;
+		const bool bSkipIfErrored;
+
+		FThreadSafeBool bDone;
+		// Increased on every reset, so that abandoned runs can't complete later ones
+		FThreadSafeCounter Generation;
+		FDateTime StartedRunning;
+		TFuture<void> Future;
+
+	public:
+
+		FAsyncUntilDoneLatentCommand(FTestSpecBase* const InSpec, EAsyncExecution InExecution, TFunction<void(const FDoneDelegate&)> InPredicate, const FTimespan& InTimeout, bool bInSkipIfErrored = false)
+			: Spec(InSpec)
+			, Execution(InExecution)
+			, Predicate(MoveTemp(InPredicate))
+			, Timeout(InTimeout)
+			, bSkipIfErrored(bInSkipIfErrored)
+			, bDone(false)
+		{}
+		virtual ~FAsyncUntilDoneLatentCommand() {}
+
+		virtual bool Update() override;
+
+	private:
+
+		void Done(int32 InGeneration)
+		{
+			if (InGeneration == Generation.GetValue())
+			{
+				bDone = true;
+				FTestSpecBase::WakeUp();
+			}
+		}
+
+		void Reset()
+		{
+			// Reset the done for the next potential run of this command
+			bDone = false;
+			Generation.Increment();
+			Spec->EndHangWatch();
+			Future = TFuture<void>();
+		}
+	};
+
+	class FFusedAsyncLatentCommand;
+
+	class FAsyncLatentCommand : public IAutomationLatentCommand
+	{
+		friend FFusedAsyncLatentCommand;
+
+	private:
+
+		FTestSpecBase* const Spec;
+		const EAsyncExecution Execution;
+		const TFunction<void()> Predicate;
+		const FTimespan Timeout;
+		const bool bSkipIfErrored;
+
+		FThreadSafeBool bDone;
+		// Increased on every reset, so that abandoned runs can't complete later ones
+		FThreadSafeCounter Generation;
+		FDateTime StartedRunning;
+		TFuture<void> Future;
+
+	public:
+
+		FAsyncLatentCommand(FTestSpecBase* const InSpec, EAsyncExecution InExecution, TFunction<void()> InPredicate, const FTimespan& InTimeout, bool bInSkipIfErrored = false)
+			: Spec(InSpec)
+			, Execution(InExecution)
+			, Predicate(MoveTemp(InPredicate))
+			, Timeout(InTimeout)
+			, bSkipIfErrored(bInSkipIfErrored)
+			, bDone(false)
+		{
+			// A fused run is abandoned on timeout or fail-fast, but commands that don't skip on errors
+			// (e.g: AfterEach) must still run, so only those that do are fused
+			if (bSkipIfErrored)
+			{
+				Spec->FusableCommands.Add(this);
+			}
+		}
+		virtual ~FAsyncLatentCommand() {}
+
+		virtual bool Update() override;
+
+	private:
+
+		void Done(int32 InGeneration)
+		{
+			if (InGeneration == Generation.GetValue())
+			{
+				bDone = true;
+				FTestSpecBase::WakeUp();
+			}
+		}
+
+		void Reset()
+		{
+			// Reset the done for the next potential run of this command
+			bDone = false;
+			Generation.Increment();
+			Spec->EndHangWatch();
+			Future = TFuture<void>();
+		}
+	};
+
+	// Runs adjacent async commands with the same execution back to back in a single task.
+	// Only commands that skip on errors are fused. Each step keeps its own timeout. Created when baking definitions
+	class FFusedAsyncLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		FTestSpecBase* const Spec;
+		const EAsyncExecution Execution;
+		const TArray<TSharedRef<FAsyncLatentCommand>> Steps;
+
+		FThreadSafeBool bDone;
+		// Increased on every reset, so that abandoned runs can't complete later ones
+		FThreadSafeCounter Generation;
+		// Step running on the task and when it started
+		FThreadSafeCounter CurrentStep;
+		FThreadSafeCounter64 StepStartedCycles;
+		TFuture<void> Future;
+
+	public:
+
+		FFusedAsyncLatentCommand(FTestSpecBase* const InSpec, TArray<TSharedRef<FAsyncLatentCommand>>&& InSteps)
+			: Spec(InSpec)
+			, Execution(InSteps[0]->Execution)
+			, Steps(MoveTemp(InSteps))
+			, bDone(false)
+		{}
+		virtual ~FFusedAsyncLatentCommand() {}
+
+		virtual bool Update() override;
+
+	private:
+
+		void Done(int32 InGeneration)
+		{
+			if (InGeneration == Generation.GetValue())
+			{
+				bDone = true;
+				FTestSpecBase::WakeUp();
+			}
+		}
+
+		void Reset()
+		{
+			bDone = false;
+			Generation.Increment();
+			Spec->EndHangWatch();
+			Future = TFuture<void>();
+		}
+	};
+
+#if AUTOMATRON_WITH_COROUTINES
+	// Drives an AsyncIt body. Implemented inline so that only modules compiled with coroutines need it
+	class FCoroutineLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		FTestSpecBase* const Spec;
+		const TFunction<FSpecCoroutine()> Predicate;
+		const FTimespan Timeout;
+		const bool bSkipIfErrored;
+
+		FDateTime StartedRunning;
+		FSpecCoroutine Coroutine;
+
+	public:
+
+		FCoroutineLatentCommand(FTestSpecBase* const InSpec, TFunction<FSpecCoroutine()> InPredicate, const FTimespan& InTimeout, bool bInSkipIfErrored = false)
+			: Spec(InSpec)
+			, Predicate(MoveTemp(InPredicate))
+			, Timeout(InTimeout)
+			, bSkipIfErrored(bInSkipIfErrored)
+		{}
+		virtual ~FCoroutineLatentCommand() {}
+
+		virtual bool Update() override
+		{
+			if (!Coroutine.IsValid())
+			{
+				if (bSkipIfErrored && Spec->HasAnyErrorsThreadSafe())
+				{
+					return true;
+				}
+
+				Coroutine = Predicate();
+				StartedRunning = FDateTime::UtcNow();
+				Spec->BeginHangWatch(Timeout);
+			}
+
+			if (Coroutine.Resume())
+			{
+				Coroutine.Reset();
+				Spec->EndHangWatch();
+				return true;
+			}
+			else if (bSkipIfErrored && Spec->IsFailingFast())
+			{
+				Coroutine.Reset();
+				Spec->EndHangWatch();
+				return true;
+			}
+			else if (FDateTime::UtcNow() >= StartedRunning + Timeout)
+			{
+				Spec->AddTimeoutError();
+				Coroutine.Reset();
+				return true;
+			}
+
+			return false;
+		}
+	};
+#endif //AUTOMATRON_WITH_COROUTINES
+
+	struct FSpecIt
+	{
+		FString Description;
+		FString Id;
+		FString Filename;
+		int32 LineNumber;
+		TSharedRef<IAutomationLatentCommand> Command;
+		FSpecItOptions Options;
+
+		FSpecIt(FString InDescription, FString InId, FString InFilename, int32 InLineNumber, TSharedRef<IAutomationLatentCommand> InCommand, FSpecItOptions InOptions = {})
+			: Description(MoveTemp(InDescription))
+			, Id(MoveTemp(InId))
+			, Filename(InFilename)
+			, LineNumber(MoveTemp(InLineNumber))
+			, Command(MoveTemp(InCommand))
+			, Options(MoveTemp(InOptions))
+		{ }
+	};
+
+	struct FSpecDefinitionScope
+	{
+		FString Description;
+		// Own tags while defining. Includes the parent's once baked
+		FSpecTags Tags;
+
+		TArray<TSharedRef<IAutomationLatentCommand>> BeforeEach;
+		TArray<TSharedRef<FSpecIt>> It;
+		TArray<TSharedRef<IAutomationLatentCommand>> AfterEach;
+
+		TArray<TSharedRef<FSpecDefinitionScope>> Children;
+	};
+
+	struct FSpec
+	{
+		FString Id;
+		FString Description;
+		FString Filename;
+		int32 LineNumber;
+		TArray<TSharedRef<IAutomationLatentCommand>> Commands;
+		FSpecItOptions Options;
+		// Own and inherited tags. See FSpecTagIndex
+		TBitArray<> TagBits;
+	};
+
+	// Outcome of the last execution of a spec
+	struct FSpecResult
+	{
+		// Duration of each attempt in seconds. More than one if the spec was retried
+		TArray<double> AttemptDurations;
+		bool bPassed = false;
+		bool bQuarantined = false;
+
+		bool PassedOnRetry() const { return bPassed && AttemptDurations.Num() > 1; }
+		double GetDuration() const
+		{
+			double Duration = 0.0;
+			for (double AttemptDuration : AttemptDurations)
+			{
+				Duration += AttemptDuration;
+			}
+			return Duration;
+		}
+	};
+
+	// Runs all baked commands of a spec, in order, from a single latent command
+	class FRunSpecLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		FTestSpecBase* const Spec;
+		const TSharedRef<FSpec> SpecToRun;
+
+		int32 CommandIndex;
+		bool bIsRunning;
+		double StartedRunning;
+		int32 EntriesBeforeAttempt;
+		int32 EntriesBeforeFirstAttempt;
+		int32 ErrorsBeforeAttempt;
+		FTestContext ContextBeforeAttempt;
+
+		FSpecResult Result;
+		FSpecResult LastResult;
+		FString InputsHash;
+		int32 LogTag;
+
+	public:
+
+		FRunSpecLatentCommand(FTestSpecBase* const InSpec, TSharedRef<FSpec> InSpecToRun, FString InInputsHash = {})
+			: Spec(InSpec)
+			, SpecToRun(MoveTemp(InSpecToRun))
+			, CommandIndex(0)
+			, bIsRunning(false)
+			, StartedRunning(0.0)
+			, EntriesBeforeAttempt(0)
+			, EntriesBeforeFirstAttempt(0)
+			, ErrorsBeforeAttempt(0)
+			, InputsHash(MoveTemp(InInputsHash))
+			, LogTag(0)
+		{}
+		virtual ~FRunSpecLatentCommand() {}
+
+		virtual bool Update() override;
+
+		const FSpec& GetSpec() const { return *SpecToRun; }
+
+		const FSpecResult& GetLastResult() const { return LastResult; }
+
+	private:
+
+		void StartAttempt();
+
+		// Returns true if the spec will run again
+		bool FinishAttempt();
+
+		void Finish();
+
+		void Reset()
+		{
+			// Reset for the next potential run of this spec
+			CommandIndex = 0;
+			bIsRunning = false;
+			Result = {};
+		}
+	};
+
+	// Runs the same specs again and again, collecting failure rate and timings
+	class FStressLatentCommand : public IAutomationLatentCommand
+	{
+	private:
+
+		FTestSpecBase* const Spec;
+		TArray<TSharedRef<FRunSpecLatentCommand>> Runners;
+
+		TArray<int32> Order;
+		int32 OrderIndex;
+		int32 RunIndex;
+		bool bRunFailed;
+		// Entries of the test before the first run. Only errors after it are accounted to runs
+		int32 FirstEntry;
+		double StartedStressing;
+		double StartedRun;
+
+		TArray<double> RunDurations;
+		int32 FailedRuns;
+		int32 FirstFailedRun;
+		int32 FirstFailedSeed;
+		FString FirstFailedSpec;
+		TArray<FString> FirstFailedLog;
+
+	public:
+
+		FStressLatentCommand(FTestSpecBase* const InSpec, TArray<TSharedRef<FRunSpecLatentCommand>> InRunners)
+			: Spec(InSpec)
+			, Runners(MoveTemp(InRunners))
+			, OrderIndex(0)
+			, RunIndex(INDEX_NONE)
+			, bRunFailed(false)
+			, FirstEntry(0)
+			, StartedStressing(0.0)
+			, StartedRun(0.0)
+			, FailedRuns(0)
+			, FirstFailedRun(INDEX_NONE)
+			, FirstFailedSeed(0)
+		{}
+		virtual ~FStressLatentCommand() {}
+
+		virtual bool Update() override;
+
+	private:
+
+		bool ShouldStartRun() const;
+		void StartRun();
+		void FinishSpec(const FRunSpecLatentCommand& Runner);
+		void FinishRun();
+		void Report();
+	};
+
+
+protected:
+
+	using Tags = FSpecTags;
+
+	/* The timespan for how long a block should be allowed to execute before giving up and failing the test */
+	FTimespan DefaultTimeout = FTimespan::FromSeconds(30);
+
+	/* Whether or not BeforeEach and It blocks should skip execution if the test has already failed */
+	bool bEnableSkipIfError = true;
+
+	/* Name of the module this spec is compiled in */
+	FString ModuleName;
+
+	/* Files read by the tests. Cached results are invalidated when their content changes */
+	TArray<FString> CacheInputs;
+
+	/* Least severe log verbosity attached to failed tests */
+	ELogVerbosity::Type LogCaptureVerbosity = ELogVerbosity::Log;
+
+	/* Maximum number of log lines attached to a failed test. Zero disables it */
+	int32 LogCaptureLines = 200;
+
+	/* Whether adjacent async BeforeEach and It commands with the same execution run in a single task. See FFusedAsyncLatentCommand */
+	bool bFuseAsyncCommands = true;
+
+private:
+
+	TArray<FString> Description;
+
+	TMap<FString, TSharedRef<FSpec>> IdToSpecMap;
+
+	TSharedPtr<FSpecDefinitionScope> RootDefinitionScope;
+
+	TArray<TSharedRef<FSpecDefinitionScope>> DefinitionScopeStack;
+
+	bool bHasBeenDefined = false;
+
+	int32 TestsRemaining = 0;
+
+	// The context of the active test
+	FTestContext CurrentContext;
+
+	// Tests the current run of this spec goes through, which can be a subset of all of them.
+	// The last one releases what the first one set up. See IsLastTest
+	int32 NumTestsInRun = 0;
+
+	// Errors, warnings and infos added from other threads, merged on the game thread
+	TQueue<FAutomationEvent, EQueueMode::Mpsc> PendingEvents;
+	FThreadSafeCounter PendingErrors;
+
+	// HasAnyErrors() as of the last merge, for threads that can't read the results directly
+	FThreadSafeBool bHadErrorsOnLastMerge;
+
+	// Whether failing the running test reaches the maximum failures of fail-fast. Set when an attempt starts
+	FThreadSafeBool bFailureReachesMaxFailures;
+
+	// Async commands that can be fused when baking. Only used to identify them
+	TSet<const IAutomationLatentCommand*> FusableCommands;
+
+	// Commands that finish on the frame they start. Only used to estimate frame costs when baking
+	TSet<const IAutomationLatentCommand*> ImmediateCommands;
+
+	// Ids defined more than once. Only the first definition is baked
+	TArray<FString> DuplicateIds;
+
+	// Set when a redefinition is requested while tests of this spec are running
+	bool bRedefinePending = false;
+
+
+public:
+
+	FTestSpecBase(const FString& InName, const bool bInComplexTask)
+		: FAutomationTestBase(InName, bInComplexTask)
+		, RootDefinitionScope(MakeShared<FSpecDefinitionScope>())
+	{
+		DefinitionScopeStack.Push(RootDefinitionScope.ToSharedRef());
+		GetAllSpecs().Add(this);
+	}
+
+	virtual ~FTestSpecBase()
+	{
+		// Keeps the order of construction. See RedefineModule
+		GetAllSpecs().RemoveSingle(this);
+	}
+
+	// Discards the definitions of the specs compiled in a module, so that they are defined and baked again on their
+	// next use. Specs with tests running wait for them to finish. Called when modules are reloaded.
+	// Hot reload keeps the previous binary loaded, so its instances of the specs are skipped and forgotten
+	static void RedefineModule(const FString& InModuleName);
+	static void RedefineAll();
+
+	virtual bool RunTest(const FString& InParameters) override;
+
+	// Thread-safe. Calls from other threads are merged into the results on the game thread
+	virtual void AddError(const FString& InError, int32 StackOffset = 0) override;
+	virtual void AddWarning(const FString& InWarning, int32 StackOffset = 0) override;
+	virtual void AddInfo(const FString& InLogItem, int32 StackOffset = 0) override;
+
+	// True if stress mode selected any of the specs of this class. See FAutomatronSettings
+	virtual bool IsStressTest() const;
+	virtual uint32 GetRequiredDeviceNum() const override { return 1; }
+
+	virtual FString GetTestSourceFileName() const override;
+	virtual int32 GetTestSourceFileLine() const override;
+	virtual FString GetTestSourceFileName(const FString& InTestName) const override;
+	virtual int32 GetTestSourceFileLine(const FString& InTestName) const override;
+
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override;
+
+
+	// BEGIN Disabled Scopes
+	void xDescribe(const FString& InDescription, TFunction<void()> DoWork) {}
+	void xDescribe(const FString& InDescription, const FSpecTags& InTags, TFunction<void()> DoWork) {}
+
+	void xIt(const FString& InDescription, TFunction<void()> DoWork) {}
+	void xIt(const FString& InDescription, EAsyncExecution Execution, TFunction<void()> DoWork) {}
+	void xIt(const FString& InDescription, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork) {}
+	void xIt(const FString& InDescription, const FSpecItOptions& Options, TFunction<void()> DoWork) {}
+	void xIt(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, TFunction<void()> DoWork) {}
+	void xIt(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork) {}
+
+	void xLatentIt(const FString& InDescription, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, const FSpecItOptions& Options, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, const FSpecItOptions& Options, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentIt(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+
+#if AUTOMATRON_WITH_COROUTINES
+	void xAsyncIt(const FString& InDescription, TFunction<FSpecCoroutine()> DoWork) {}
+	void xAsyncIt(const FString& InDescription, const FTimespan& Timeout, TFunction<FSpecCoroutine()> DoWork) {}
+	void xAsyncIt(const FString& InDescription, const FSpecItOptions& Options, TFunction<FSpecCoroutine()> DoWork) {}
+	void xAsyncIt(const FString& InDescription, const FSpecItOptions& Options, const FTimespan& Timeout, TFunction<FSpecCoroutine()> DoWork) {}
+#endif
+
+	void xBeforeEach(TFunction<void()> DoWork) {}
+	void xBeforeEach(EAsyncExecution Execution, TFunction<void()> DoWork) {}
+	void xBeforeEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork) {}
+
+	void xLatentBeforeEach(TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentBeforeEach(const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentBeforeEach(EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentBeforeEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+
+	void xAfterEach(TFunction<void()> DoWork) {}
+	void xAfterEach(EAsyncExecution Execution, TFunction<void()> DoWork) {}
+	void xAfterEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork) {}
+
+	void xLatentAfterEach(TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentAfterEach(const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentAfterEach(EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	void xLatentAfterEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork) {}
+	// END Disabled Scopes
+
+
+	// BEGIN Enabled Scopes
+	void Describe(const FString& InDescription, TFunction<void()> DoWork);
+	void Describe(const FString& InDescription, const FSpecTags& InTags, TFunction<void()> DoWork);
+
+	void It(const FString& InDescription, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FSingleExecuteLatentCommand>(this, DoWork, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void It(const FString& InDescription, const FSpecItOptions& Options, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FSingleExecuteLatentCommand>(this, DoWork, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void It(const FString& InDescription, EAsyncExecution Execution, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, DefaultTimeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void It(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, DefaultTimeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void It(const FString& InDescription, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, Timeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void It(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, Timeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FUntilDoneLatentCommand>(this, DoWork, DefaultTimeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, const FSpecItOptions& Options, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FUntilDoneLatentCommand>(this, DoWork, DefaultTimeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FUntilDoneLatentCommand>(this, DoWork, Timeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, const FSpecItOptions& Options, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FUntilDoneLatentCommand>(this, DoWork, Timeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, DefaultTimeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, DefaultTimeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, Timeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void LatentIt(const FString& InDescription, const FSpecItOptions& Options, EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, Timeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+#if AUTOMATRON_WITH_COROUTINES
+	// The whole body runs from a single latent command, resumed every frame until it finishes
+	void AsyncIt(const FString& InDescription, TFunction<FSpecCoroutine()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FCoroutineLatentCommand>(this, DoWork, DefaultTimeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void AsyncIt(const FString& InDescription, const FSpecItOptions& Options, TFunction<FSpecCoroutine()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FCoroutineLatentCommand>(this, DoWork, DefaultTimeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+
+	void AsyncIt(const FString& InDescription, const FTimespan& Timeout, TFunction<FSpecCoroutine()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FCoroutineLatentCommand>(this, DoWork, Timeout, bEnableSkipIfError)));
+		PopDescription(InDescription);
+	}
+
+	void AsyncIt(const FString& InDescription, const FSpecItOptions& Options, const FTimespan& Timeout, TFunction<FSpecCoroutine()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		const TArray<FProgramCounterSymbolInfo> Stack = FPlatformStackWalk::GetStack(1, 1);
+
+		PushDescription(InDescription);
+		CurrentScope->It.Push(MakeShared<FSpecIt>(GetDescription(), GetId(), Stack[0].Filename, Stack[0].LineNumber, MakeShared<FCoroutineLatentCommand>(this, DoWork, Timeout, bEnableSkipIfError), Options));
+		PopDescription(InDescription);
+	}
+#endif //AUTOMATRON_WITH_COROUTINES
+
+	void BeforeEach(TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShareable(new FSingleExecuteLatentCommand(this, DoWork, bEnableSkipIfError)));
+	}
+
+	void BeforeEach(EAsyncExecution Execution, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, DefaultTimeout, bEnableSkipIfError));
+	}
+
+	void BeforeEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, Timeout, bEnableSkipIfError));
+	}
+
+	void LatentBeforeEach(TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShared<FUntilDoneLatentCommand>(this, DoWork, DefaultTimeout, bEnableSkipIfError));
+	}
+
+	void LatentBeforeEach(const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShared<FUntilDoneLatentCommand>(this, DoWork, Timeout, bEnableSkipIfError));
+	}
+
+	void LatentBeforeEach(EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, DefaultTimeout, bEnableSkipIfError));
+	}
+
+	void LatentBeforeEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->BeforeEach.Push(MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, Timeout, bEnableSkipIfError));
+	}
+
+	void AfterEach(TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShareable(new FSingleExecuteLatentCommand(this, DoWork)));
+	}
+
+	void AfterEach(EAsyncExecution Execution, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, DefaultTimeout));
+	}
+
+	void AfterEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void()> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShared<FAsyncLatentCommand>(this, Execution, DoWork, Timeout));
+	}
+
+	void LatentAfterEach(TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShared<FUntilDoneLatentCommand>(this, DoWork, DefaultTimeout));
+	}
+
+	void LatentAfterEach(const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShared<FUntilDoneLatentCommand>(this, DoWork, Timeout));
+	}
+
+	void LatentAfterEach(EAsyncExecution Execution, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, DefaultTimeout));
+	}
+
+	void LatentAfterEach(EAsyncExecution Execution, const FTimespan& Timeout, TFunction<void(const FDoneDelegate&)> DoWork)
+	{
+		const TSharedRef<FSpecDefinitionScope> CurrentScope = DefinitionScopeStack.Last();
+		CurrentScope->AfterEach.Push(MakeShared<FAsyncUntilDoneLatentCommand>(this, Execution, DoWork, Timeout));
+	}
+
+	// Thread-safe. True if the active test has errors, including those not merged from other threads yet
+	bool HasAnyErrorsThreadSafe() const;
+
+	// Thread-safe. True if the active test already failed and its failure stops the run by fail-fast.
+	// Commands waiting on a done delegate stop waiting and long async bodies can poll it to give up early.
+	bool IsFailingFast() const;
+
+	// Compares Data with the golden file "Snapshots/<TestName>/<Name>.snap" next to the spec source file.
+	// Missing snapshots are created. Run with -Automatron.UpdateSnapshots to rewrite mismatching ones
+	bool TestMatchesSnapshot(const FString& Name, TArrayView<const uint8> Data) { return CompareSnapshot(Name, Data, false); }
+	bool TestMatchesSnapshot(const FString& Name, const TArray<uint8>& Data) { return CompareSnapshot(Name, Data, false); }
+
+	// Expectations on a TMockFunction or TSpy. Thread-safe, so async tests can use them
+	template<typename TMock>
+	bool TestCalledTimes(const FString& What, const TMock& Mock, int32 Expected)
+	{
+		const int32 NumCalls = Mock.GetNumCalls();
+		if (NumCalls != Expected)
+		{
+			AddError(FString::Printf(TEXT("Expected '%s' to be called %i times, but it was called %i times."), *What, Expected, NumCalls), 1);
+			return false;
+		}
+		return true;
+	}
+
+	template<typename TMock>
+	bool TestCalled(const FString& What, const TMock& Mock)
+	{
+		if (!Mock.WasCalled())
+		{
+			AddError(FString::Printf(TEXT("Expected '%s' to be called."), *What), 1);
+			return false;
+		}
+		return true;
+	}
+
+	template<typename TMock>
+	bool TestNotCalled(const FString& What, const TMock& Mock) { return TestCalledTimes(What, Mock, 0); }
+
+	// Only recorded calls are compared. Calls over the capacity of the mock are reported
+	template<typename TMock, typename... TArgs>
+	bool TestCalledWith(const FString& What, const TMock& Mock, const TArgs&... Args)
+	{
+		if (!Mock.WasCalledWith(Args...))
+		{
+			AddError(FString::Printf(TEXT("Expected '%s' to be called with matching arguments, but none of its %i recorded calls matched%s."),
+				*What, Mock.GetNumRecordedCalls(), Mock.HasOverflown()? TEXT(" (some calls were over capacity)") : TEXT("")), 1);
+			return false;
+		}
+		return true;
+	}
+
+	int32 GetNumTests() const { return IdToSpecMap.Num(); }
+	int32 GetTestsRemaining() const { return NumTestsInRun - CurrentContext.GetId(); }
+	FTestContext GetCurrentContext() const { return CurrentContext; }
+	bool IsFirstTest() const { return CurrentContext.GetId() == 1; }
+	bool IsLastTest() const { return CurrentContext.GetId() == NumTestsInRun; }
+
+protected:
+
+#if AUTOMATRON_WITH_COROUTINES
+	// BEGIN AsyncIt awaitables
+	static FSpecNextFrameAwaiter NextFrame() { return {}; }
+
+	static FSpecDelayAwaiter Delay(const FTimespan& Duration) { return { Duration }; }
+
+	template<typename ResultType>
+	static TSpecFutureAwaiter<ResultType> WaitFor(TFuture<ResultType>&& Future) { return { MoveTemp(Future) }; }
+
+	// Resumes once Predicate returns true. Checked once per frame, e.g: a world condition
+	template<typename TPredicate>
+	static TSpecConditionAwaiter<TPredicate> WaitUntil(TPredicate Predicate) { return { MoveTemp(Predicate) }; }
+	// END AsyncIt awaitables
+#endif //AUTOMATRON_WITH_COROUTINES
+
+	void EnsureDefinitions() const;
+
+	virtual void RunDefine()
+	{
+		PreDefine();
+		Define();
+		PostDefine();
+	}
+	virtual void PreDefine();
+	virtual void Define() = 0;
+	virtual void PostDefine();
+
+	// Defines and bakes, recording the cost of both. See FSpecBakeReport
+	void DefineAndBake();
+
+	void BakeDefinitions(FSpecBakeEntry& OutEntry);
+
+	// Replaces runs of adjacent async commands with fused ones
+	void FuseAsyncCommands(TArray<TSharedRef<IAutomationLatentCommand>>& Commands);
+
+	void Redefine();
+
+	// Redefines now, or after the running tests of this spec finish
+	void RequestRedefine();
+
+	// Whether passing results can be reused while the module binary and CacheInputs don't change.
+	// Only specs whose result depends exclusively on those should return true
+	virtual bool CanCacheResults() const { return true; }
+
+	// Whether failures of a test are reported as warnings. Defaults to the quarantine list. See FAutomatronSettings
+	virtual bool IsQuarantined(const FString& SpecId) const;
+
+	// Called when fail-fast stops the remaining tests. Release here anything a skipped test would have cleaned up
+	virtual void OnFailFast() {}
+
+	// Whether the game thread can sleep while a test waits for latent work, instead of polling every frame.
+	// Specs that need frames to keep ticking while they wait (e.g: a world) must return false
+	virtual bool CanSleepWhileWaiting() const { return true; }
+
+	// True if fail-fast reached the maximum number of failures for this spec or the whole run
+	// PendingFailures counts failures of running tests, not reported yet
+	bool HasReachedMaxFailures(int32 PendingFailures = 0) const;
+
+	// Whether a test matches a tag query, including the tags inherited from its Describe scopes
+	bool MatchesTags(const FString& SpecId, const FSpecTagQuery& Query) const;
+
+	// If bAsText, Data is UTF-8 and mismatches are reported by line
+	bool CompareSnapshot(const FString& Name, TArrayView<const uint8> Data, bool bAsText);
+
+private:
+
+	// Every spec instance, to find them when modules are reloaded
+	static TArray<FTestSpecBase*>& GetAllSpecs();
+
+	void PushDescription(const FString& InDescription)
+	{
+		Description.Add(InDescription);
+	}
+
+	void PopDescription(const FString& InDescription)
+	{
+		Description.RemoveAt(Description.Num() - 1);
+	}
+
+	FString GetDescription() const;
+
+	FString GetId() const;
+
+	// Hang watchdog of the running latent command. See FSpecHangWatchdog.
+	// Begin before dispatching an async body, which passes the returned id to WatchCurrentThread
+	uint32 BeginHangWatch(const FTimespan& Timeout);
+	void EndHangWatch();
+	// Called from the thread running an async body, so that its callstack is captured too
+	static void WatchCurrentThread(uint32 WatchId);
+
+	// Fails the test with the callstacks captured by the hang watchdog, if any
+	void AddTimeoutError();
+
+	// Wakes up the game thread if it was sleeping on a waiting test. Thread-safe
+	static void WakeUp();
+
+	// Sleeps until woken up or for -Automatron.IdleSleepMs, whatever happens first.
+	// An attended editor only sleeps what's left of a frame at -Automatron.IdleFrameRate
+	void SleepWhileWaiting() const;
+
+	// Moves errors and warnings added from other threads into the results. Game thread only
+	void MergePendingEvents();
+
+	// Whether the spec passes the run filters (like impact analysis)
+	bool IsSelected(const FSpec& Spec) const;
+	// Specs that will be enqueued: selected and not skipped as cached passes
+	int32 GetNumTestsToRun(const TArray<TSharedRef<FSpec>>& Specs, const FString& InputsHash) const;
+
+	// Adds a spec that won't run to the result reports
+	void ReportSkipped(const FSpec& Spec, const FString& Reason) const;
+
+	// Removes errors added since an entry index, returning their messages. Entries before it are untouched
+	TArray<FString> ExtractErrorsSince(int32 FirstEntry);
+};
+
+inline void FTestSpecBase::EnsureDefinitions() const
+{
+	// Requested while the previous run of this spec was in progress
+	if (bRedefinePending && !CurrentContext)
+	{
+		const_cast<FTestSpecBase*>(this)->Redefine();
+	}
+	if (!bHasBeenDefined)
+	{
+		const_cast<FTestSpecBase*>(this)->DefineAndBake();
+	}
+}
+
+
+inline FString FTestSpecBase::GetTestSourceFileName() const
+{
+	return FAutomationTestBase::GetTestSourceFileName();
+}
+
+inline int32 FTestSpecBase::GetTestSourceFileLine() const
+{
+	return FAutomationTestBase::GetTestSourceFileLine();
+}
@@ -0,0 +1,96 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Misc/AutomationTest.h>
+
+#include "Base/TestSpecBase.h"
+
+
+// Initializes an spec instance at global execution time
+// and registers it to the system
+template<typename T>
+struct TSpecRegister
+{
+    static TSpecRegister<T> Register;
+
+    T Instance;
+
+    TSpecRegister() : Instance{}
+    {
+        Instance.Setup();
+    }
+};
+
+template<typename T>
+TSpecRegister<T> TSpecRegister<T>::Register{};
+
+
+// Spec without engine dependencies. Use it for tests of Core level code,
+// or FTestSpec (Automatron module) when a world is needed
+class AUTOMATRONCORE_API FCoreTestSpec : public FTestSpecBase
+{
+	FString ClassName;
+	FString PrettyName;
+	FString FileName;
+	int32 LineNumber = -1;
+	uint32 Flags = 0;
+
+
+public:
+
+	FCoreTestSpec() : FTestSpecBase("", false) {}
+
+	virtual FString GetTestSourceFileName() const override { return FileName; }
+	virtual int32 GetTestSourceFileLine() const override { return LineNumber; }
+	virtual uint32 GetTestFlags() const override { return Flags; }
+
+	const FString& GetClassName() const { return ClassName; }
+	const FString& GetPrettyName() const { return PrettyName; }
+
+protected:
+
+	virtual FString GetBeautifiedTestName() const override { return PrettyName; }
+
+	template<uint32 TFlags>
+	void Setup(FString&& InName, FString&& InPrettyName, FString&& InFileName, int32 InLineNumber, FString&& InModuleName = {});
+
+	// Used to indicate a test is pending to be implemented.
+	void TestNotImplemented()
+	{
+		AddWarning(TEXT("Test not implemented"), 1);
+	}
+
+private:
+
+	void Reregister(const FString& NewName)
+	{
+		FAutomationTestFramework::Get().UnregisterAutomationTest(TestName);
+		TestName = NewName;
+		FAutomationTestFramework::Get().RegisterAutomationTest(TestName, this);
+	}
+};
+
+
+template<uint32 TFlags>
+inline void FCoreTestSpec::Setup(FString&& InName, FString&& InPrettyName, FString&& InFileName, int32 InLineNumber, FString&& InModuleName)
+{
+	static_assert(TFlags & EAutomationTestFlags::ApplicationContextMask, "AutomationTest has no application flag. It shouldn't run. See AutomationTest.h."); \
+	static_assert(((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::SmokeFilter) ||
+		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::EngineFilter) ||
+		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::ProductFilter) ||
+		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::PerfFilter) ||
+		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::StressFilter) ||
+		((TFlags & EAutomationTestFlags::FilterMask) == EAutomationTestFlags::NegativeFilter),
+		"All AutomationTests must have exactly 1 filter type specified.  See AutomationTest.h.");
+
+	ClassName = InName;
+	PrettyName = MoveTemp(InPrettyName);
+	FileName = MoveTemp(InFileName);
+	LineNumber = InLineNumber;
+	ModuleName = MoveTemp(InModuleName);
+	Flags = TFlags;
+
+	Reregister(InName);
+}
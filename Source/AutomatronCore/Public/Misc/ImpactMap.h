@@ -0,0 +1,67 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Maps specs to the source files and modules they exercise.
+// Recorded with -Automatron.RecordImpactMap=<file>, then used with -Automatron.ImpactMap=<file>
+// and -Automatron.ChangedFiles=<file> (e.g: the output of 'git diff --name-only') to only run affected specs.
+// The map is static: a spec is mapped to its source files and, through its module, to the modules it declares as
+// dependencies. Code a spec reaches at runtime without a declared module dependency is not tracked.
+class AUTOMATRONCORE_API FSpecImpactMap
+{
+	struct FModuleInfo
+	{
+		// Relative to the project directory
+		FString Directory;
+		TArray<FString> Dependencies;
+	};
+
+	struct FSpecEntry
+	{
+		FString Module;
+		// Relative to the project directory
+		TArray<FString> Files;
+	};
+
+	TMap<FString, FModuleInfo> Modules;
+	TMap<FString, FSpecEntry> Specs;
+
+	bool bSelecting = false;
+	bool bAllAffected = false;
+	TArray<FString> ChangedFiles;
+	TSet<FString> AffectedModules;
+
+
+public:
+
+	static FSpecImpactMap& Get();
+
+	bool IsRecording() const;
+	bool IsSelecting() const { return bSelecting; }
+
+	void Record(const FString& TestName, const FString& SpecId, const TArray<FString>& SourceFiles);
+	void Save() const;
+
+	// Selects the specs of the map at MapPath affected by the files listed in ChangedFilesPath.
+	// Returns false if the map can't be loaded, which leaves every spec affected
+	bool Select(const FString& MapPath, const FString& ChangedFilesPath);
+
+	// True if the spec could be affected by any changed file. Specs unknown to the map are always affected
+	bool IsAffected(const FString& TestName, const FString& SpecId) const;
+
+private:
+
+	void Initialize();
+	void ScanModules();
+	bool Load(const FString& Path);
+	void LoadChangedFiles(const FString& Path);
+
+	FString FindModule(const FString& RelativeFile) const;
+
+	static FString MakeKey(const FString& TestName, const FString& SpecId) { return TestName + TEXT(" ") + SpecId; }
+	static FString MakeProjectRelative(const FString& File);
+	static bool MatchesChangedFile(const FString& ChangedFile, const FString& RelativeFile);
+};
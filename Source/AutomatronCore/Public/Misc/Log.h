@@ -0,0 +1,8 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+AUTOMATRONCORE_API DECLARE_LOG_CATEGORY_EXTERN(LogAutomatron, Log, All);
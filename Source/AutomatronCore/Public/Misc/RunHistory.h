@@ -0,0 +1,69 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+struct FAutomatronSettings;
+
+
+// Durations of every run, appended to HistoryFile as "<Run>,<Milliseconds>,<Key>" lines.
+// Each run is compared with the previous ones to find tests that got slower.
+class AUTOMATRONCORE_API FSpecRunHistory
+{
+public:
+
+	// Regressions need some history to tell them apart from noise
+	static constexpr int32 MinRunsToCompare = 3;
+
+	struct FRegression
+	{
+		FString Key;
+		double Duration = 0.0;
+		double Median = 0.0;
+		double Deviation = 0.0;
+		int32 NumRuns = 0;
+	};
+
+	// Last run of a history compared with the ones before it
+	struct FComparison
+	{
+		FString Run;
+		int32 NumTests = 0;
+		// Tests with at least MinRunsToCompare previous durations
+		int32 NumCompared = 0;
+		// Largest slowdown first
+		TArray<FRegression> Regressions;
+	};
+
+private:
+
+	// Durations of this run in milliseconds
+	TMap<FString, double> Durations;
+
+
+public:
+
+	static FSpecRunHistory& Get();
+
+	bool IsEnabled() const;
+
+	// Adds a duration to this run. Key identifies a test or a benchmark across runs
+	void Record(const FString& Key, double Seconds);
+
+	// Appends this run to the history and writes the regression report
+	void Save();
+
+	// Compares the last run in the history with the ones before it. Returns false if there is no history
+	static bool WriteReport();
+
+	// Compares the last run in the history at HistoryPath with up to Settings.HistoryRuns runs before it.
+	// A test regressed if it's slower than its median by RegressionDeviations deviations and by RegressionMinChange.
+	// Returns false if there is no history
+	static bool Compare(const FString& HistoryPath, const FAutomatronSettings& Settings, FComparison& OutComparison);
+
+private:
+
+	// Median and scaled median absolute deviation. Robust to the odd slow run
+	static void GetMedianAndDeviation(TArray<double> Values, double& OutMedian, double& OutDeviation);
+};
@@ -0,0 +1,57 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Golden file comparison. Each snapshot has a small ".hash" sidecar with its size and a hash per chunk,
+// so matching data is checked without reading the snapshot itself. It is only read to describe mismatches.
+struct AUTOMATRONCORE_API FSpecSnapshot
+{
+	enum class EFormat : uint8
+	{
+		Binary,
+		// Diffs are reported by line
+		Text
+	};
+
+	enum class EResult : uint8
+	{
+		Matched,
+		Mismatched,
+		Created,
+		Updated,
+		Failed
+	};
+
+	// Stored in "Snapshots/<TestName>" next to SourceFile
+	FSpecSnapshot(const FString& SourceFile, const FString& TestName, const FString& Name);
+
+	// Rewrites a mismatching snapshot if bUpdate, instead of describing the mismatch
+	EResult Compare(TArrayView<const uint8> Data, EFormat Format, bool bUpdate);
+
+	const FString& GetPath() const { return Path; }
+
+	// Describes why the last Compare failed
+	const FString& GetReport() const { return Report; }
+
+private:
+
+	FString Path;
+
+	// Where mismatching data is saved for inspection
+	FString ReceivedPath;
+
+	FString Report;
+
+	bool Write(TArrayView<const uint8> Data) const;
+	bool WriteHashes(int64 Size, const TArray<uint64>& Hashes) const;
+	bool ReadHashes(int64& OutSize, TArray<uint64>& OutHashes) const;
+
+	void DescribeBinaryDiff(TArrayView<const uint8> Expected, TArrayView<const uint8> Actual, int32 FirstChunk);
+	void DescribeTextDiff(TArrayView<const uint8> Expected, TArrayView<const uint8> Actual);
+
+	static void HashChunks(TArrayView<const uint8> Data, TArray<uint64>& OutHashes);
+	static FString GetHashPath(const FString& SnapshotPath) { return SnapshotPath + TEXT(".hash"); }
+};
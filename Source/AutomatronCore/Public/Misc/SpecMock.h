@@ -0,0 +1,157 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <HAL/ThreadSafeBool.h>
+#include <HAL/ThreadSafeCounter.h>
+#include <Templates/TypeCompatibleBytes.h>
+
+
+template<typename TSignature, int32 Capacity = 32>
+class TMockFunction;
+
+// Callable that records its calls into a buffer of fixed capacity, so recording a call doesn't allocate by itself.
+// Arguments are copied though, and copies of types like FString or TArray allocate. Where allocations matter, mock
+// signatures with arguments cheap to copy (e.g: FName instead of FString). Calls can be recorded from any thread, e.g: async tests. Calls over capacity are counted
+// but their arguments are not kept. Returns a default value unless told otherwise with Returns or Invokes.
+//
+// E.g: TMockFunction<bool(int32)> OnDamage;
+//      Component->OnDamage = OnDamage.AsFunction();
+//      TestCalledWith("Damaged", OnDamage, 10);
+template<typename TReturn, typename... TArgs, int32 Capacity>
+class TMockFunction<TReturn(TArgs...), Capacity>
+{
+	static_assert(Capacity > 0, "Mocks need room for at least one call");
+
+public:
+
+	// Arguments of a call, copied
+	using FCall = TTuple<typename TDecay<TArgs>::Type...>;
+
+private:
+
+	TTypeCompatibleBytes<FCall> Calls[Capacity];
+
+	// A call is only readable once its arguments are fully copied
+	FThreadSafeBool Recorded[Capacity];
+
+	FThreadSafeCounter NumCalls;
+
+	TFunction<TReturn(TArgs...)> Implementation;
+
+
+public:
+
+	TMockFunction() = default;
+	TMockFunction(const TMockFunction&) = delete;
+	TMockFunction& operator=(const TMockFunction&) = delete;
+	~TMockFunction() { Reset(); }
+
+	TReturn operator()(TArgs... Args)
+	{
+		const int32 Index = NumCalls.Increment() - 1;
+		if (Index < Capacity)
+		{
+			new (Calls[Index].GetTypedPtr()) FCall(Args...);
+			Recorded[Index] = true;
+		}
+
+		if (Implementation)
+		{
+			return Implementation(Forward<TArgs>(Args)...);
+		}
+		return TReturn();
+	}
+
+	// Wraps the mock to be passed where a TFunction is expected. The mock must outlive it
+	TFunction<TReturn(TArgs...)> AsFunction()
+	{
+		return [this](TArgs... Args) -> TReturn
+		{
+			return (*this)(Forward<TArgs>(Args)...);
+		};
+	}
+
+	// Behaviour is set up before calls are made. Not thread-safe
+	void Invokes(TFunction<TReturn(TArgs...)> InImplementation)
+	{
+		Implementation = MoveTemp(InImplementation);
+	}
+
+	template<typename TValue>
+	void Returns(TValue Value)
+	{
+		Implementation = [Value](TArgs...) -> TReturn { return Value; };
+	}
+
+	// Forgets all calls. Not thread-safe, so don't call it while calls may be recorded
+	void Reset()
+	{
+		const int32 NumRecorded = GetNumRecordedCalls();
+		for (int32 Index = 0; Index < NumRecorded; ++Index)
+		{
+			if (Recorded[Index])
+			{
+				DestructItem(Calls[Index].GetTypedPtr());
+				Recorded[Index] = false;
+			}
+		}
+		NumCalls.Reset();
+	}
+
+	// Including calls over capacity
+	int32 GetNumCalls() const { return NumCalls.GetValue(); }
+	int32 GetNumRecordedCalls() const { return FMath::Min(GetNumCalls(), Capacity); }
+	bool WasCalled() const { return GetNumCalls() > 0; }
+	bool HasOverflown() const { return GetNumCalls() > Capacity; }
+
+	// Arguments of a recorded call. E.g: Mock.GetCall(0).template Get<0>()
+	const FCall& GetCall(int32 Index) const
+	{
+		check(Index >= 0 && Index < GetNumRecordedCalls() && Recorded[Index]);
+		return *Calls[Index].GetTypedPtr();
+	}
+
+	const FCall& GetLastCall() const { return GetCall(GetNumRecordedCalls() - 1); }
+
+	// Number of recorded calls with arguments equal to Args
+	template<typename... TExpectedArgs>
+	int32 CountCallsWith(const TExpectedArgs&... Args) const
+	{
+		static_assert(sizeof...(TExpectedArgs) == sizeof...(TArgs), "Expected arguments don't match the mocked signature");
+
+		const FCall Expected{ Args... };
+		int32 Count = 0;
+		const int32 NumRecorded = GetNumRecordedCalls();
+		for (int32 Index = 0; Index < NumRecorded; ++Index)
+		{
+			// Calls still being recorded by another thread are skipped
+			if (Recorded[Index] && *Calls[Index].GetTypedPtr() == Expected)
+			{
+				++Count;
+			}
+		}
+		return Count;
+	}
+
+	template<typename... TExpectedArgs>
+	bool WasCalledWith(const TExpectedArgs&... Args) const
+	{
+		return CountCallsWith(Args...) > 0;
+	}
+};
+
+
+// Mock that calls through to a real function while recording its calls.
+// E.g: TSpy<int32(int32)> Square{ [](int32 X) { return X * X; } };
+template<typename TSignature, int32 Capacity = 32>
+class TSpy : public TMockFunction<TSignature, Capacity>
+{
+public:
+
+	TSpy(TFunction<TSignature> Real)
+	{
+		this->Invokes(MoveTemp(Real));
+	}
+};
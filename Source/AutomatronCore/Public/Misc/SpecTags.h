@@ -0,0 +1,64 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+// Assigns a bit to every tag name, shared by all specs so that baked specs only store bits
+class AUTOMATRONCORE_API FSpecTagIndex
+{
+	TMap<FString, int32> Bits;
+
+
+public:
+
+	static FSpecTagIndex& Get();
+
+	int32 FindOrAdd(const FString& Tag);
+	TBitArray<> MakeBits(const TArray<FString>& Tags);
+
+	int32 Num() const { return Bits.Num(); }
+};
+
+
+// Selects specs by their tags. Compiled once against FSpecTagIndex, so matching a spec only tests bits.
+// Supports tags, '!' (not), '&' (and), '|' (or) and parentheses. E.g: "net & !slow", "(ui | input) & !flaky"
+class AUTOMATRONCORE_API FSpecTagQuery
+{
+	enum class EOp : uint8
+	{
+		Tag,
+		Not,
+		And,
+		Or
+	};
+
+	struct FInstruction
+	{
+		EOp Op;
+		int32 Bit;
+	};
+
+	// Postfix order
+	TArray<FInstruction> Instructions;
+	bool bValid = true;
+
+
+public:
+
+	// Query passed with -Automatron.Tags=<query>
+	static const FSpecTagQuery& Get();
+
+	// Returns false and leaves an error if the query is malformed
+	bool Parse(const FString& Query, FString& OutError);
+
+	// An empty query matches everything. An invalid one matches nothing
+	bool Matches(const TBitArray<>& TagBits) const;
+
+	bool IsEmpty() const { return Instructions.Num() == 0; }
+
+private:
+
+	struct FParser;
+};
@@ -0,0 +1,20 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+using UnrealBuildTool;
+
+// Specs of AutomatronCore. Only depends on Core, so that AutomatronRunner can run them
+public class AutomatronCoreTest : ModuleRules
+{
+	public AutomatronCoreTest(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		bEnforceIWYU = true;
+		bLegacyPublicIncludePaths = false;
+
+		PublicDependencyModuleNames.AddRange(new string[]
+		{
+			"Core",
+			"AutomatronCore"
+		});
+	}
+}
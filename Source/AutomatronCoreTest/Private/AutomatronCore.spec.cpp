@@ -0,0 +1,395 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <Async/ParallelFor.h>
+#include <HAL/FileManager.h>
+#include <Misc/AutomationTest.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+
+#include "AutomatronCore.h"
+#include "AutomatronSettings.h"
+#include "Misc/ImpactMap.h"
+#include "Misc/RunHistory.h"
+#include "Misc/Snapshot.h"
+#include "Misc/SpecTags.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Counts allocations made by the calling thread, forwarding all of them to the allocator in use
+class FAllocationCounter final : public FMalloc
+{
+	FMalloc* Inner = nullptr;
+	uint32 ThreadId = 0;
+	int32 NumAllocations = 0;
+
+public:
+
+	// Number of allocations the calling thread made while running Scope
+	static int32 Count(TFunctionRef<void()> Scope)
+	{
+		// Never destroyed while the process runs, as other threads may still be calling it after it's swapped back
+		static FAllocationCounter Counter;
+		Counter.Inner = GMalloc;
+		Counter.ThreadId = FPlatformTLS::GetCurrentThreadId();
+		Counter.NumAllocations = 0;
+		FPlatformMisc::MemoryBarrier();
+		GMalloc = &Counter;
+
+		Scope();
+
+		GMalloc = Counter.Inner;
+		FPlatformMisc::MemoryBarrier();
+		return Counter.NumAllocations;
+	}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT("AllocationCounter"); }
+
+private:
+
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+		{
+			++NumAllocations;
+		}
+	}
+};
+
+// Specs of AutomatronCore itself. They only need Core, so they also run in AutomatronRunner
+SPEC(FAutomatronCoreSpec, FCoreTestSpec, "Automatron.Core",
+	EAutomationTestFlags::EngineFilter |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	It("Runs without an engine", [this]() {
+		// Succeed
+	});
+
+	Describe("Tags", Tags{"tagged"}, [this]() {
+		It("Can be selected by tags", Tags{"fast"}, [this]() {
+			// Selected by -Automatron.Tags="tagged & fast"
+		});
+
+		It("Inherits the tags of its scopes", [this]() {
+			FSpecTagQuery Query;
+			FString Error;
+			Query.Parse(TEXT("tagged & fast"), Error);
+			TestTrue("Own and inherited tags", MatchesTags(TEXT("Tags Can be selected by tags"), Query));
+			TestFalse("Tags of a sibling", MatchesTags(TEXT("Tags Inherits the tags of its scopes"), Query));
+
+			// Tags don't leak to other scopes
+			Query.Parse(TEXT("tagged"), Error);
+			TestFalse("Untagged scope", MatchesTags(TEXT("Runs without an engine"), Query));
+		});
+	});
+
+	Describe("Tag queries", [this]() {
+		auto Matches = [](const TCHAR* QueryText, const TArray<FString>& Tags) {
+			FSpecTagQuery Query;
+			FString Error;
+			Query.Parse(QueryText, Error);
+			return Query.Matches(FSpecTagIndex::Get().MakeBits(Tags));
+		};
+
+		It("Parses tags and operators", [this, Matches]() {
+			TestTrue("Tag", Matches(TEXT("a"), { TEXT("a") }));
+			TestTrue("Case insensitive", Matches(TEXT("A"), { TEXT("a") }));
+			TestTrue("And", Matches(TEXT("a & b"), { TEXT("a"), TEXT("b") }));
+			TestFalse("And, missing one", Matches(TEXT("a & b"), { TEXT("a") }));
+			TestTrue("Or", Matches(TEXT("a | b"), { TEXT("b") }));
+			TestFalse("Not", Matches(TEXT("!a"), { TEXT("a") }));
+			TestTrue("Empty matches all", Matches(TEXT(""), {}));
+		});
+
+		It("Binds not, then and, then or", [this, Matches]() {
+			// a | (b & !c)
+			TestTrue("Left of or", Matches(TEXT("a | b & !c"), { TEXT("a"), TEXT("c") }));
+			TestTrue("Right of or", Matches(TEXT("a | b & !c"), { TEXT("b") }));
+			TestFalse("Negated", Matches(TEXT("a | b & !c"), { TEXT("b"), TEXT("c") }));
+			TestFalse("Parentheses", Matches(TEXT("(a | b) & !c"), { TEXT("a"), TEXT("c") }));
+		});
+
+		It("Rejects invalid queries", [this, Matches]() {
+			for (const TCHAR* Invalid : { TEXT("a &"), TEXT("(a"), TEXT("a)"), TEXT("a b"), TEXT("& a"), TEXT("!") })
+			{
+				FSpecTagQuery Query;
+				FString Error;
+				TestFalse(FString::Printf(TEXT("Parse '%s'"), Invalid), Query.Parse(Invalid, Error));
+				TestFalse(FString::Printf(TEXT("Error of '%s'"), Invalid), Error.IsEmpty());
+				// Invalid queries match nothing
+				TestFalse(FString::Printf(TEXT("Match '%s'"), Invalid), Matches(Invalid, { TEXT("a") }));
+			}
+		});
+	});
+
+	Describe("Mocks", [this]() {
+		It("Records calls and arguments", [this]() {
+			TMockFunction<int32(int32, const FString&)> Mock;
+			Mock.Returns(3);
+
+			TestEqual("Result", Mock(1, TEXT("One")), 3);
+			Mock(2, TEXT("Two"));
+
+			TestCalledTimes("Mock", Mock, 2);
+			TestCalledWith("Mock", Mock, 2, FString(TEXT("Two")));
+			TestEqual("Last argument", Mock.GetLastCall().Get<1>(), FString(TEXT("Two")));
+		});
+
+		It("Counts calls over capacity", [this]() {
+			TMockFunction<void(int32), 2> Mock;
+			for (int32 Index = 0; Index < 3; ++Index)
+			{
+				Mock(Index);
+			}
+			TestCalledTimes("Mock", Mock, 3);
+			TestTrue("Overflown", Mock.HasOverflown());
+			TestFalse("Arguments over capacity aren't kept", Mock.WasCalledWith(2));
+		});
+
+		It("Calls through spies", [this]() {
+			TSpy<int32(int32)> Square{ [](int32 X) { return X * X; } };
+			TestEqual("Result", Square(4), 16);
+			TestCalledWith("Square", Square, 4);
+		});
+
+		It("Doesn't allocate recording arguments cheap to copy", [this]() {
+			TMockFunction<void(int32, float), 64> Mock;
+			const int32 NumAllocations = FAllocationCounter::Count([&Mock]() {
+				for (int32 Index = 0; Index < 64; ++Index)
+				{
+					Mock(Index, 1.f);
+				}
+				Mock.Reset();
+			});
+			TestEqual("Allocations", NumAllocations, 0);
+		});
+
+		It("Records from async tests", EAsyncExecution::ThreadPool, [this]() {
+			TMockFunction<void(int32)> Mock;
+			ParallelFor(16, [&Mock](int32 Index) { Mock(Index); });
+
+			TestCalledTimes("Mock", Mock, 16);
+			TestCalledWith("Mock", Mock, 15);
+		});
+	});
+
+	Describe("Snapshots", [this]() {
+		// Snapshots are stored next to this source file, in a directory every test starts without
+		const FString SourceFile = FPaths::AutomationTransientDir() / TEXT("SnapshotSpec") / TEXT("Spec.cpp");
+		auto ToBytes = [](const TCHAR* Text) {
+			const FTCHARToUTF8 Converter(Text);
+			return TArray<uint8>((const uint8*)Converter.Get(), Converter.Length());
+		};
+
+		BeforeEach([SourceFile]() {
+			IFileManager::Get().DeleteDirectory(*FPaths::GetPath(SourceFile), false, true);
+		});
+
+		It("Creates missing snapshots", [this, SourceFile, ToBytes]() {
+			FSpecSnapshot Snapshot{ SourceFile, TestName, TEXT("Lines") };
+			TestTrue("Created", Snapshot.Compare(ToBytes(TEXT("a\nb\n")), FSpecSnapshot::EFormat::Text, false) == FSpecSnapshot::EResult::Created);
+			TestTrue("Snapshot written", FPaths::FileExists(Snapshot.GetPath()));
+		});
+
+		It("Matches the same data", [this, SourceFile, ToBytes]() {
+			FSpecSnapshot Snapshot{ SourceFile, TestName, TEXT("Lines") };
+			Snapshot.Compare(ToBytes(TEXT("a\nb\n")), FSpecSnapshot::EFormat::Text, false);
+			TestTrue("Matched", Snapshot.Compare(ToBytes(TEXT("a\nb\n")), FSpecSnapshot::EFormat::Text, false) == FSpecSnapshot::EResult::Matched);
+		});
+
+		It("Reports mismatching lines", [this, SourceFile, ToBytes]() {
+			FSpecSnapshot Snapshot{ SourceFile, TestName, TEXT("Lines") };
+			Snapshot.Compare(ToBytes(TEXT("a\nb\n")), FSpecSnapshot::EFormat::Text, false);
+			TestTrue("Mismatched", Snapshot.Compare(ToBytes(TEXT("a\nc\nd\n")), FSpecSnapshot::EFormat::Text, false) == FSpecSnapshot::EResult::Mismatched);
+
+			const FString& Report = Snapshot.GetReport();
+			TestTrue("Changed line reported", Report.Contains(TEXT("2: expected 'b', got 'c'")));
+			TestTrue("Added line reported", Report.Contains(TEXT("3: added 'd'")));
+			TestFalse("Matching line reported", Report.Contains(TEXT("1:")));
+		});
+
+		It("Reports mismatching bytes", [this, SourceFile]() {
+			FSpecSnapshot Snapshot{ SourceFile, TestName, TEXT("Bytes") };
+			Snapshot.Compare(TArray<uint8>{ 1, 2, 3, 4 }, FSpecSnapshot::EFormat::Binary, false);
+			TestTrue("Mismatched", Snapshot.Compare(TArray<uint8>{ 1, 9, 3 }, FSpecSnapshot::EFormat::Binary, false) == FSpecSnapshot::EResult::Mismatched);
+
+			const FString& Report = Snapshot.GetReport();
+			TestTrue("Sizes reported", Report.Contains(TEXT("Expected 4 bytes, got 3")));
+			TestTrue("Changed byte reported", Report.Contains(TEXT("0x00000001 (1 bytes): expected 02, got 09")));
+			TestTrue("Missing byte reported", Report.Contains(TEXT("0x00000003: 1 bytes missing")));
+		});
+
+		It("Updates mismatching snapshots", [this, SourceFile, ToBytes]() {
+			FSpecSnapshot Snapshot{ SourceFile, TestName, TEXT("Lines") };
+			Snapshot.Compare(ToBytes(TEXT("a\nb\n")), FSpecSnapshot::EFormat::Text, false);
+			TestTrue("Updated", Snapshot.Compare(ToBytes(TEXT("a\nc\n")), FSpecSnapshot::EFormat::Text, true) == FSpecSnapshot::EResult::Updated);
+			TestTrue("Matches the update", Snapshot.Compare(ToBytes(TEXT("a\nc\n")), FSpecSnapshot::EFormat::Text, false) == FSpecSnapshot::EResult::Matched);
+		});
+	});
+
+	Describe("Impact map", [this]() {
+		const FString Dir = FPaths::AutomationTransientDir() / TEXT("ImpactMapSpec");
+
+		// Game tests depend on Game. Tools depends on nothing. Shared isn't a module
+		BeforeEach([Dir]() {
+			const FString Json = TEXT("{ \"Modules\": {")
+				TEXT(" \"Game\": { \"Directory\": \"Source/Game\", \"Dependencies\": [\"Core\"] },")
+				TEXT(" \"GameTests\": { \"Directory\": \"Source/GameTests\", \"Dependencies\": [\"Game\"] },")
+				TEXT(" \"Tools\": { \"Directory\": \"Source/Tools\", \"Dependencies\": [] } },")
+				TEXT(" \"Specs\": {")
+				TEXT(" \"Game.Tests Spec\": { \"Module\": \"GameTests\", \"Files\": [\"Source/GameTests/Private/Game.spec.cpp\"] },")
+				TEXT(" \"Tools.Tests Spec\": { \"Module\": \"Tools\", \"Files\": [\"Source/Tools/Private/Tools.spec.cpp\", \"Shared/Helpers.h\"] } } }");
+			FFileHelper::SaveStringToFile(Json, *(Dir / TEXT("ImpactMap.json")));
+		});
+
+		auto Select = [Dir](FSpecImpactMap& Map, const TArray<FString>& ChangedFiles) {
+			const FString ChangedFilesPath = Dir / TEXT("ChangedFiles.txt");
+			FFileHelper::SaveStringArrayToFile(ChangedFiles, *ChangedFilesPath);
+			return Map.Select(Dir / TEXT("ImpactMap.json"), ChangedFilesPath);
+		};
+
+		It("Matches changed files by their trailing path segments", [this, Select]() {
+			// Changed files are often relative to the repository root, not the project
+			FSpecImpactMap Map;
+			TestTrue("Selecting", Select(Map, { TEXT("Project/Shared/Helpers.h") }));
+			TestTrue("Spec using the file", Map.IsAffected(TEXT("Tools.Tests"), TEXT("Spec")));
+			TestFalse("Other spec", Map.IsAffected(TEXT("Game.Tests"), TEXT("Spec")));
+
+			FSpecImpactMap PartialMap;
+			Select(PartialMap, { TEXT("Project/MyShared/Helpers.h"), TEXT("Shared/Helpers.h.orig") });
+			TestFalse("Files only sharing part of a segment", PartialMap.IsAffected(TEXT("Tools.Tests"), TEXT("Spec")));
+		});
+
+		It("Selects specs of modules depending on changed ones", [this, Select]() {
+			FSpecImpactMap Map;
+			Select(Map, { TEXT("Source/Game/Private/Game.cpp") });
+			TestTrue("Spec of a dependent module", Map.IsAffected(TEXT("Game.Tests"), TEXT("Spec")));
+			TestFalse("Spec of an unrelated module", Map.IsAffected(TEXT("Tools.Tests"), TEXT("Spec")));
+		});
+
+		It("Selects all specs when build files change", [this, Select]() {
+			FSpecImpactMap Map;
+			Select(Map, { TEXT("Source/Game/Game.Build.cs") });
+			TestTrue("Spec of an unrelated module", Map.IsAffected(TEXT("Tools.Tests"), TEXT("Spec")));
+
+			FSpecImpactMap TargetMap;
+			Select(TargetMap, { TEXT("Build/Game.Target.cs") });
+			TestTrue("Spec of any module", TargetMap.IsAffected(TEXT("Game.Tests"), TEXT("Spec")));
+		});
+
+		It("Always selects specs missing from the map", [this, Select]() {
+			FSpecImpactMap Map;
+			Select(Map, { TEXT("Source/Tools/Private/Tools.cpp") });
+			TestTrue("New spec", Map.IsAffected(TEXT("Game.Tests"), TEXT("New spec")));
+			TestFalse("Mapped spec", Map.IsAffected(TEXT("Game.Tests"), TEXT("Spec")));
+		});
+
+		It("Selects all specs without a map", [this, Select]() {
+			AddExpectedError(TEXT("Couldn't load impact map"), EAutomationExpectedErrorFlags::Contains, 1);
+			FSpecImpactMap Map;
+			TestFalse("Selecting", Map.Select(FPaths::AutomationTransientDir() / TEXT("Missing.json"), TEXT("")));
+			TestTrue("Any spec", Map.IsAffected(TEXT("Game.Tests"), TEXT("Spec")));
+		});
+	});
+
+	Describe("Run history", [this]() {
+		// Three runs before the last one, enough to compare
+		const FString HistoryPath = FPaths::AutomationTransientDir() / TEXT("RunHistorySpec") / TEXT("History.csv");
+		BeforeEach([HistoryPath]() {
+			const TArray<FString> Lines = {
+				TEXT("R1,100,Stable"),    TEXT("R1,100,Slower"), TEXT("R1,100,Much slower"), TEXT("R1,100,Noisy"), TEXT("R1,100,Steady"),
+				TEXT("R2,102,Stable"),    TEXT("R2,102,Slower"), TEXT("R2,102,Much slower"), TEXT("R2,200,Noisy"), TEXT("R2,100,Steady"), TEXT("R2,100,New"),
+				TEXT("R3,98,Stable"),     TEXT("R3,98,Slower"),  TEXT("R3,98,Much slower"),  TEXT("R3,60,Noisy"),  TEXT("R3,100,Steady"),  TEXT("R3,100,New"),
+				// Last run
+				TEXT("R4,101,Stable"),    TEXT("R4,150,Slower"), TEXT("R4,300,Much slower"), TEXT("R4,150,Noisy"), TEXT("R4,105,Steady"), TEXT("R4,1000,New")
+			};
+			FFileHelper::SaveStringArrayToFile(Lines, *HistoryPath);
+		});
+
+		It("Flags tests slower than their noise and the minimum change", [this, HistoryPath]() {
+			FAutomatronSettings Settings;
+			Settings.HistoryRuns = 10;
+			Settings.RegressionDeviations = 3.0;
+			Settings.RegressionMinChange = 0.1;
+
+			FSpecRunHistory::FComparison Comparison;
+			if (!TestTrue("Compared", FSpecRunHistory::Compare(HistoryPath, Settings, Comparison)))
+			{
+				return;
+			}
+			TestEqual("Run", Comparison.Run, FString(TEXT("R4")));
+			TestEqual("Tests", Comparison.NumTests, 6);
+			// New has only two previous runs
+			TestEqual("Tests compared", Comparison.NumCompared, 5);
+
+			// Noisy is 50% slower, but within 3 deviations of its median. Steady is over its zero deviation, but only 5% slower
+			TArray<FString> Keys;
+			for (const FSpecRunHistory::FRegression& Regression : Comparison.Regressions)
+			{
+				Keys.Add(Regression.Key);
+			}
+			TestEqual("Regressions, largest first", FString::Join(Keys, TEXT(", ")), FString(TEXT("Much slower, Slower")));
+
+			if (Comparison.Regressions.Num() == 2)
+			{
+				const FSpecRunHistory::FRegression& Slower = Comparison.Regressions[1];
+				TestEqual("Median", Slower.Median, 100.0);
+				// Median absolute deviation of 2ms, scaled to be comparable with a standard deviation
+				TestEqual("Deviation", Slower.Deviation, 2.0 * 1.4826, 1e-6);
+				TestEqual("Previous runs", Slower.NumRuns, FSpecRunHistory::MinRunsToCompare);
+			}
+		});
+
+		It("Only compares the last HistoryRuns runs", [this, HistoryPath]() {
+			FAutomatronSettings Settings;
+			Settings.HistoryRuns = FSpecRunHistory::MinRunsToCompare - 1;
+
+			FSpecRunHistory::FComparison Comparison;
+			FSpecRunHistory::Compare(HistoryPath, Settings, Comparison);
+			TestEqual("Tests compared", Comparison.NumCompared, 0);
+			TestEqual("Regressions", Comparison.Regressions.Num(), 0);
+		});
+	});
+
+	Describe("Events from other threads", [this]() {
+		static const TCHAR* const Message = TEXT("Info added from a worker thread");
+		const TSharedRef<bool> bAdded = MakeShared<bool>(false);
+
+		It("Are added from any thread", EAsyncExecution::ThreadPool, [this, bAdded]() {
+			AddInfo(Message);
+			*bAdded = true;
+		});
+
+		// Defined after the async test, so it runs once its events were merged
+		It("Are merged into the results", [this, bAdded]() {
+			if (!*bAdded)
+			{
+				return;
+			}
+			const bool bMerged = ExecutionInfo.GetEntries().ContainsByPredicate([](const FAutomationExecutionEntry& Entry) {
+				return Entry.Event.Type == EAutomationEventType::Info && Entry.Event.Message == Message;
+			});
+			TestTrue("Info merged", bMerged);
+		});
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
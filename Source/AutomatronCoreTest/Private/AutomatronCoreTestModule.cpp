@@ -0,0 +1,6 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AutomatronCoreTestModule.h"
+
+
+IMPLEMENT_MODULE(FAutomatronCoreTestModule, AutomatronCoreTest)
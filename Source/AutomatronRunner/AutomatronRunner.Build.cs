@@ -0,0 +1,22 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class AutomatronRunner : ModuleRules
+{
+	public AutomatronRunner(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		bEnforceIWYU = true;
+		bLegacyPublicIncludePaths = false;
+
+		PrivateIncludePathModuleNames.Add("Launch");
+
+		PrivateDependencyModuleNames.AddRange(new string[]
+		{
+			"Core",
+			"Projects",
+			"AutomatronCore"
+		});
+	}
+}
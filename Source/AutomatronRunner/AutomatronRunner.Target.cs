@@ -0,0 +1,40 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+// Console program running specs that only depend on AutomatronCore. No editor, display or GPU needed
+// E.g: AutomatronRunner -Filter=MyLibrary -Automatron.JUnit=Results.xml
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class AutomatronRunnerTarget : TargetRules
+{
+	// Modules with Core-only specs (FCoreTestSpec) linked into the runner
+	public static readonly string[] TestModules = new string[]
+	{
+		"AutomatronCoreTest"
+	};
+
+	public AutomatronRunnerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "AutomatronRunner";
+		ExtraModuleNames.AddRange(TestModules);
+
+		EnablePlugins.Add("Automatron");
+
+		// AutomatronCore is a developer tool
+		bBuildDeveloperTools = true;
+
+		// Keep startup minimal
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bCompileICU = false;
+		bBuildWithEditorOnlyData = false;
+		bUseLoggingInShipping = true;
+
+		bIsBuildingConsoleApplication = true;
+		bForceCompileDevelopmentAutomationTests = true;
+	}
+}
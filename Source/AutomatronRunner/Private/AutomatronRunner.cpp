@@ -0,0 +1,110 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <Async/TaskGraphInterfaces.h>
+#include <Containers/Ticker.h>
+#include <Misc/AutomationTest.h>
+#include <Misc/CommandLine.h>
+#include <Misc/Parse.h>
+#include <Modules/ModuleManager.h>
+#include <RequiredProgramMainCPPInclude.h>
+
+
+DEFINE_LOG_CATEGORY_STATIC(LogAutomatronRunner, Display, All);
+
+IMPLEMENT_APPLICATION(AutomatronRunner, "AutomatronRunner");
+
+
+namespace
+{
+	// Runs one test until all its latent commands are done, ticking what a program doesn't tick on its own
+	bool RunTest(FAutomationTestFramework& Framework, const FAutomationTestInfo& Test)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		double LastTickTime = StartTime;
+
+		Framework.StartTestByName(Test.GetTestName(), 0);
+		while (!Framework.ExecuteLatentCommands())
+		{
+			const double Now = FPlatformTime::Seconds();
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			FTicker::GetCoreTicker().Tick(Now - LastTickTime);
+			LastTickTime = Now;
+			++GFrameCounter;
+			FPlatformProcess::Sleep(0.f);
+		}
+
+		FAutomationTestExecutionInfo ExecutionInfo;
+		const bool bPassed = Framework.StopTest(ExecutionInfo);
+
+		for (const FAutomationExecutionEntry& Entry : ExecutionInfo.GetEntries())
+		{
+			switch (Entry.Event.Type)
+			{
+			case EAutomationEventType::Error:
+				UE_LOG(LogAutomatronRunner, Error, TEXT("  %s"), *Entry.Event.Message);
+				break;
+			case EAutomationEventType::Warning:
+				UE_LOG(LogAutomatronRunner, Warning, TEXT("  %s"), *Entry.Event.Message);
+				break;
+			default:
+				UE_LOG(LogAutomatronRunner, Display, TEXT("  %s"), *Entry.Event.Message);
+				break;
+			}
+		}
+
+		UE_LOG(LogAutomatronRunner, Display, TEXT("%s %s (%.3fs)"),
+			bPassed? TEXT("PASSED") : TEXT("FAILED"), *Test.GetDisplayName(), FPlatformTime::Seconds() - StartTime);
+		return bPassed;
+	}
+}
+
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV);
+
+	// Hooks reports, caches and log capture to the run
+	FModuleManager::Get().LoadModuleChecked(TEXT("AutomatronCore"));
+
+	FAutomationTestFramework& Framework = FAutomationTestFramework::Get();
+	Framework.SetRequestedTestFilter(EAutomationTestFlags::SmokeFilter | EAutomationTestFlags::EngineFilter |
+		EAutomationTestFlags::ProductFilter | EAutomationTestFlags::PerfFilter | EAutomationTestFlags::StressFilter);
+
+	FString Filter;
+	FParse::Value(FCommandLine::Get(), TEXT("-Filter="), Filter);
+
+	TArray<FAutomationTestInfo> Tests;
+	Framework.GetValidTestNames(Tests);
+	Tests.RemoveAll([&Filter](const FAutomationTestInfo& Test)
+	{
+		return !Filter.IsEmpty() && !Test.GetDisplayName().Contains(Filter) && !Test.GetTestName().Contains(Filter);
+	});
+	Tests.Sort([](const FAutomationTestInfo& A, const FAutomationTestInfo& B)
+	{
+		return A.GetDisplayName() < B.GetDisplayName();
+	});
+
+	UE_LOG(LogAutomatronRunner, Display, TEXT("Running %i tests"), Tests.Num());
+
+	int32 Failures = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	Framework.OnBeforeAllTestsEvent.Broadcast();
+	for (const FAutomationTestInfo& Test : Tests)
+	{
+		if (!RunTest(Framework, Test))
+		{
+			++Failures;
+		}
+	}
+	Framework.OnAfterAllTestsEvent.Broadcast();
+
+	UE_LOG(LogAutomatronRunner, Display, TEXT("%i of %i tests passed (%.2fs)"),
+		Tests.Num() - Failures, Tests.Num(), FPlatformTime::Seconds() - StartTime);
+
+	FEngineLoop::AppPreExit();
+	FModuleManager::Get().UnloadModulesAtShutdown();
+	FEngineLoop::AppExit();
+
+	return Failures > 0? 1 : 0;
+}
@@ -1,9 +1,15 @@
 // Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
 
 #include <CoreMinimal.h>
+#include <Async/Async.h>
+#include <Containers/Ticker.h>
+#include <GameFramework/Pawn.h>
 #include <Misc/AutomationTest.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
 
 #include "Automatron.h"
+#include "AutomatronSettings.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -16,6 +22,391 @@ SPEC(FAutomatronSpec, FTestSpec, "Automatron",
 	It("Can run a test", [this]() {
 		// Succeed
 	});
+
+	Describe("Retries", [this]() {
+		const TSharedRef<int32> Attempts = MakeShared<int32>(0);
+		It("Passes on retry", FSpecItOptions().Retries(1), [this, Attempts]() {
+			// Runs of this spec after the first one pass straight away
+			if (++*Attempts == 1)
+			{
+				AddError(TEXT("Expected failure of the first attempt"), 0);
+			}
+		});
+	});
+
+	Describe("Quarantine", [this]() {
+		It("Matches quarantined ids by prefix", [this]() {
+			FAutomatronSettings Settings;
+			Settings.QuarantinedSpecs = { TEXT("Automatron Quarantine*"), TEXT("Exact id") };
+			TestTrue("Prefix", Settings.IsQuarantined(TEXT("Automatron Quarantine Any test")));
+			TestTrue("Exact", Settings.IsQuarantined(TEXT("Exact id")));
+			TestFalse("Other", Settings.IsQuarantined(TEXT("Exact id but longer")));
+		});
+	});
+
+	Describe("Replays", [this]() {
+		It("Survive a save and load round trip", [this]() {
+			FSpecReplay Replay;
+			Replay.SetInitialStateHash(0x1234);
+			Replay.AddFrame(1.f / 60.f, { MakeTuple(FName(TEXT("Jump")), 1.f) });
+			Replay.AddFrame(1.f / 30.f, {});
+			Replay.AddFrame(1.f / 60.f, { MakeTuple(FName(TEXT("Move")), 0.5f), MakeTuple(FName(TEXT("Jump")), 0.f) });
+			Replay.SetFinalStateHash(0x5678);
+
+			const FString Path = FPaths::AutomationTransientDir() / TEXT("RoundTrip.replay");
+			TestTrue("Saved", Replay.Save(Path));
+
+			FSpecReplay Loaded;
+			if (!TestTrue("Loaded", Loaded.Load(Path)))
+			{
+				return;
+			}
+			TestEqual("Frames", Loaded.GetNumFrames(), 3);
+			TestEqual("Initial state", Loaded.GetInitialStateHash(), (uint64)0x1234);
+			TestEqual("Final state", Loaded.GetFinalStateHash(), (uint64)0x5678);
+			TestEqual("Frame time", Loaded.GetDeltaSeconds(1), 1.f / 30.f);
+
+			TArray<TPair<FName, float>> Inputs;
+			auto Record = [&Inputs](FName Channel, float Value) { Inputs.Emplace(Channel, Value); };
+			Loaded.ApplyInputs(1, Record);
+			TestEqual("Inputs of an empty frame", Inputs.Num(), 0);
+			Loaded.ApplyInputs(2, Record);
+			if (TestEqual("Inputs", Inputs.Num(), 2))
+			{
+				TestEqual("Channel", Inputs[1].Key, FName(TEXT("Jump")));
+				TestEqual("Value", Inputs[0].Value, 0.5f);
+			}
+		});
+
+		It("Fail to load when corrupt", [this]() {
+			FSpecReplay Replay;
+			Replay.AddFrame(1.f / 60.f, { MakeTuple(FName(TEXT("Jump")), 1.f) });
+			const FString Path = FPaths::AutomationTransientDir() / TEXT("Corrupt.replay");
+			Replay.Save(Path);
+
+			TArray<uint8> Data;
+			FFileHelper::LoadFileToArray(Data, *Path);
+			// Header and half of the initial state hash
+			Data.SetNum(12);
+			FFileHelper::SaveArrayToFile(Data, *Path);
+
+			FSpecReplay Loaded;
+			TestFalse("Loaded", Loaded.Load(Path));
+		});
+	});
+
+#if AUTOMATRON_WITH_COROUTINES
+	AsyncIt("Can await inside a test", [this]() -> FSpecCoroutine {
+		const uint64 StartFrame = GFrameCounter;
+		co_await NextFrame();
+		TestTrue("Resumed on a later frame", GFrameCounter > StartFrame);
+
+		const int32 Value = co_await WaitFor(Async(EAsyncExecution::ThreadPool, []() { return 5; }));
+		TestEqual("Future value", Value, 5);
+
+		FSpecSignal Signal;
+		Async(EAsyncExecution::ThreadPool, [Done = Signal.AsDoneDelegate()]() { Done.Execute(); });
+		co_await Signal;
+	});
+#endif
+}
+
+
+SPEC(FAutomatronIsolatedWorldSpec, FTestSpec, "Automatron.IsolatedWorld",
+	EAutomationTestFlags::EngineFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	bUseIsolatedWorld = true;
+
+	It("Begins play", [this]() {
+		TestTrue("Begun play", GetWorld()->HasBegunPlay());
+		TestNotNull("Game mode", GetWorld()->GetAuthGameMode());
+	});
+
+	LatentIt("Ticks spawned actors", [this](const FDoneDelegate& Done) {
+		// Pawns tick by default
+		APawn* Pawn = GetWorld()->SpawnActor<APawn>();
+		if (!TestNotNull("Pawn", Pawn))
+		{
+			Done.Execute();
+			return;
+		}
+		TestTrue("Pawn begun play", Pawn->HasActorBegunPlay());
+
+		const TWeakObjectPtr<APawn> WeakPawn = Pawn;
+		const float SpawnTime = GetWorld()->GetTimeSeconds();
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakPawn, SpawnTime, Done](float) {
+			if (!WeakPawn.IsValid())
+			{
+				Done.ExecuteIfBound();
+				return false;
+			}
+			if (WeakPawn->PrimaryActorTick.GetLastTickGameTimeSeconds() <= SpawnTime)
+			{
+				// Times out if the pawn never ticks
+				return true;
+			}
+			WeakPawn->Destroy();
+			Done.ExecuteIfBound();
+			return false;
+		}));
+	});
+}
+
+SPEC(FAutomatronFrameBudgetSpec, FTestSpec, "Automatron.FrameBudget",
+	EAutomationTestFlags::EngineFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	bUseIsolatedWorld = true;
+
+	auto WaitFrames = [](FSpecFrameCapture& Capture, const FDoneDelegate& Done) {
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([&Capture, Done](float) {
+			if (Capture.IsCapturing() && Capture.GetNumFrames() < 10)
+			{
+				return true;
+			}
+			Done.ExecuteIfBound();
+			return false;
+		}));
+	};
+
+	CapturedLatentIt("Passes within budget", WaitFrames, [this](const FSpecFrameCapture& Capture) {
+		TestEqual("Frames", Capture.GetNumFrames(), 10);
+		TestFrameBudget(Capture, 0.99, 10000.0);
+		TestAverageBudget(Capture, 10000.0);
+	});
+
+	CapturedLatentIt("Fails over budget", WaitFrames, [this](const FSpecFrameCapture& Capture) {
+		AddExpectedError(TEXT("over the budget"), EAutomationExpectedErrorFlags::Contains, 2);
+		TestFalse("Frame budget", TestFrameBudget(Capture, 1.0, 0.0));
+		TestFalse("Average budget", TestAverageBudget(Capture, 0.0));
+	});
+}
+
+SPEC(FAutomatronNetSpec, FTestSpec, "Automatron.Net",
+	EAutomationTestFlags::EngineFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	NetClients = 2;
+
+	It("Connects every client", [this]() {
+		TestNotNull("Server", GetWorld());
+		TestEqual("Clients", GetNumClientWorlds(), 2);
+		for (int32 Index = 0; Index < GetNumClientWorlds(); ++Index)
+		{
+			const UWorld* Client = GetClientWorld(Index);
+			if (TestNotNull(FString::Printf(TEXT("Client %i"), Index), Client))
+			{
+				TestEqual(FString::Printf(TEXT("Net mode of client %i"), Index), (int32)Client->GetNetMode(), (int32)NM_Client);
+				TestNotNull(FString::Printf(TEXT("Player of client %i"), Index), Client->GetFirstPlayerController());
+			}
+		}
+	});
+
+	It("Steps server and clients together", [this]() {
+		const float ServerTime = GetWorld()->GetTimeSeconds();
+		const float ClientTime = GetClientWorld(0)->GetTimeSeconds();
+
+		StepNetWorlds(60, 1.f / 60.f);
+
+		TestEqual("Server time", GetWorld()->GetTimeSeconds() - ServerTime, 1.f, 0.01f);
+		TestEqual("Client time", GetClientWorld(0)->GetTimeSeconds() - ClientTime, 1.f, 0.01f);
+	});
+
+	It("Captures the bandwidth of the server", [this]() {
+		FSpecFrameCapture Capture;
+		Capture.Start(GetWorld());
+		CaptureNetBandwidth(Capture);
+		StepNetWorlds(30);
+		Capture.Stop();
+
+		TestEqual("Frames", Capture.GetNumFrames(), 30);
+		TestTrue("Bytes sent", Capture.GetMax(FSpecNetSession::OutBytesStat) > 0.0);
+		TestNotNull("Bytes sent to a client", Capture.GetValues(FSpecNetSession::GetClientOutBytesStat(1)));
+		TestNetBandwidth(Capture, 1.0, 1024.0 * 1024.0);
+	});
+}
+
+// Defines the same test twice. Only the first definition is baked, and running it reports the duplicate
+class FAutomatronDuplicatedSpec : public FCoreTestSpec
+{
+public:
+
+	virtual bool RunTest(const FString& InParameters) override
+	{
+		AddExpectedError(TEXT("is defined more than once"), EAutomationExpectedErrorFlags::Contains, 1);
+		return FCoreTestSpec::RunTest(InParameters);
+	}
+};
+
+SPEC(FAutomatronDuplicateSpec, FAutomatronDuplicatedSpec, "Automatron.Duplicates",
+	EAutomationTestFlags::EngineFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	It("Is defined twice", [this]() {
+		TArray<FString> Names;
+		TArray<FString> Commands;
+		GetTests(Names, Commands);
+		TestEqual("Baked tests", Commands.Num(), 1);
+	});
+
+	It("Is defined twice", [this]() {
+		AddError(TEXT("The second definition of a test must not run"), 0);
+	});
+}
+
+// Quarantines the tests whose id starts with "Quarantined". Passes only if their failures are reported as warnings
+class FAutomatronQuarantinedSpec : public FCoreTestSpec
+{
+protected:
+
+	virtual bool IsQuarantined(const FString& SpecId) const override { return SpecId.StartsWith(TEXT("Quarantined")); }
+};
+
+SPEC(FAutomatronQuarantineSpec, FAutomatronQuarantinedSpec, "Automatron.Quarantine",
+	EAutomationTestFlags::EngineFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	static const TCHAR* const FailureMessage = TEXT("Expected failure of a quarantined test");
+	const TSharedRef<bool> bFailed = MakeShared<bool>(false);
+
+	It("Quarantined test fails", [this, bFailed]() {
+		*bFailed = true;
+		AddError(FailureMessage, 0);
+	});
+
+	// Defined after the quarantined test, so it runs once its errors were turned into warnings
+	It("Reports failures as warnings", [this, bFailed]() {
+		if (!*bFailed)
+		{
+			AddInfo(TEXT("The quarantined test didn't run before this one, nothing to check"));
+			return;
+		}
+
+		int32 NumErrors = 0;
+		int32 NumWarnings = 0;
+		for (const FAutomationExecutionEntry& Entry : ExecutionInfo.GetEntries())
+		{
+			if (Entry.Event.Message.Contains(FailureMessage))
+			{
+				NumErrors += Entry.Event.Type == EAutomationEventType::Error;
+				NumWarnings += Entry.Event.Type == EAutomationEventType::Warning && Entry.Event.Message.StartsWith(TEXT("[Quarantined]"));
+			}
+		}
+		TestEqual("Errors left", NumErrors, 0);
+		TestEqual("Quarantine warnings", NumWarnings, 1);
+	});
+}
+
+// Compares the latency of a test whose three async steps are dispatched from the game thread one after the other,
+// as unfused commands are, with one that runs them back to back in a single task, as fused commands do.
+// Both run interleaved in the same test so that they see the same load. Timing is too noisy to assert on,
+// so averages are reported and the test duration goes to the run history
+SPEC(FAutomatronAsyncLatencySpec, FCoreTestSpec, "Automatron.Benchmark.AsyncLatency",
+	EAutomationTestFlags::PerfFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	static constexpr int32 NumRounds = 20;
+	static constexpr int32 NumSteps = 3;
+
+	LatentIt("Fused and unfused async steps", [this](const FDoneDelegate& Done) {
+		struct FState
+		{
+			int32 Round = 0;
+			int32 Step = 0;
+			double StartTime = 0.;
+			// Indexed by whether the steps were fused
+			double TotalLatency[2] = {};
+			TFuture<void> Future;
+		};
+		const TSharedRef<FState> State = MakeShared<FState>();
+
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, State, Done](float) {
+			const bool bFused = State->Round % 2 == 1;
+			if (!State->Future.IsValid())
+			{
+				State->Step = 0;
+				State->StartTime = FPlatformTime::Seconds();
+				State->Future = Async(EAsyncExecution::ThreadPool, [bFused]() {
+					for (int32 Step = 0; Step < (bFused? NumSteps : 1); ++Step)
+					{
+						// Empty steps, only dispatch costs are measured
+					}
+				});
+				return true;
+			}
+
+			if (!State->Future.IsReady())
+			{
+				return true;
+			}
+
+			if (!bFused && ++State->Step < NumSteps)
+			{
+				// The next step starts on the frame after the last one finished
+				State->Future = Async(EAsyncExecution::ThreadPool, []() {});
+				return true;
+			}
+
+			State->TotalLatency[bFused] += FPlatformTime::Seconds() - State->StartTime;
+			State->Future = TFuture<void>();
+			if (++State->Round < NumRounds * 2)
+			{
+				// Like the next test, the next round starts on the next frame
+				return true;
+			}
+
+			AddInfo(FString::Printf(TEXT("Average latency: %.3fms fused, %.3fms unfused"),
+				State->TotalLatency[1] * 1000. / NumRounds, State->TotalLatency[0] * 1000. / NumRounds));
+			Done.ExecuteIfBound();
+			return false;
+		}));
+	});
+}
+
+// Reports the cost of recording calls with a mock, compared to a fake logging into an array.
+// Timing is too noisy to assert on. That mocks don't allocate is tested in Automatron.Core
+SPEC(FAutomatronMockBenchmarkSpec, FCoreTestSpec, "Automatron.Benchmark.MockRecording",
+	EAutomationTestFlags::PerfFilter |
+	EAutomationTestFlags::ApplicationContextMask)
+{
+	static constexpr int32 Rounds = 1000;
+	static constexpr int32 CallsPerRound = 256;
+
+	// Nanoseconds per call
+	auto Measure = [](TFunctionRef<void()> Round) {
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < Rounds; ++Index)
+		{
+			Round();
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1e9 / (Rounds * CallsPerRound);
+	};
+
+	It("Reports the cost of recording calls", [this, Measure]() {
+		TMockFunction<void(int32, float), CallsPerRound> Mock;
+		const double MockNanoseconds = Measure([&Mock]() {
+			Mock.Reset();
+			for (int32 Index = 0; Index < CallsPerRound; ++Index)
+			{
+				Mock(Index, 1.f);
+			}
+		});
+		TestEqual("Recorded calls", Mock.GetNumRecordedCalls(), CallsPerRound);
+
+		TArray<TTuple<int32, float>> Calls;
+		const double FakeNanoseconds = Measure([&Calls]() {
+			// As fakes created per test do
+			Calls.Empty();
+			for (int32 Index = 0; Index < CallsPerRound; ++Index)
+			{
+				Calls.Emplace(Index, 1.f);
+			}
+		});
+		TestEqual("Faked calls", Calls.Num(), CallsPerRound);
+
+		AddInfo(FString::Printf(TEXT("Mock: %.2fns per call, array fake: %.2fns per call"), MockNanoseconds, FakeNanoseconds));
+	});
 }
 
 #endif //WITH_DEV_AUTOMATION_TESTS